@@ -0,0 +1,184 @@
+#include <stdio.h>
+#include <assert.h>
+#include <unistd.h>
+#include <getopt.h>
+#include <stdlib.h>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+#include "sim.h"
+
+
+extern int debug;
+
+/* Aging (NFU with a shift register): every frame has an 8-bit history
+ * of its reference bit. At every tick the histories shift right by one,
+ * the reference bits come in at the top and are cleared. The page with
+ * the smallest history is the one used least recently, at the resolution
+ * of a tick. The 8 ticks of history span the -T window.
+ *
+ * Both sweeps run over the byte arrays of the reference bits and the
+ * histories, 16 frames at a time with SSE2.
+ */
+
+struct aging {
+    unsigned char *history;  // Indexed by frame
+    long period;             // References between ticks
+    long next_tick;
+    int hand;                // Where the search for a victim starts
+};
+
+/* Shift the reference bit of every frame into its history.
+ */
+static void aging_tick(struct sim *s, struct aging *aging) {
+    unsigned char *history = aging->history;
+    unsigned char *ref = s->coremap.ref;
+    int n = s->frames_used;
+    int i = 0;
+
+#ifdef __SSE2__
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i low7 = _mm_set1_epi8(0x7f);
+    const __m128i top = _mm_set1_epi8((char) 0x80);
+    for (; i + 16 <= n; i += 16) {
+        __m128i h = _mm_loadu_si128((__m128i *) (history + i));
+        __m128i r = _mm_loadu_si128((__m128i *) (ref + i));
+        // There are no byte shifts: shift 16-bit lanes and drop the bit
+        // that crossed over from the next byte
+        h = _mm_and_si128(_mm_srli_epi16(h, 1), low7);
+        h = _mm_or_si128(h, _mm_andnot_si128(_mm_cmpeq_epi8(r, zero), top));
+        _mm_storeu_si128((__m128i *) (history + i), h);
+        _mm_storeu_si128((__m128i *) (ref + i), zero);
+    }
+#endif
+    for (; i < n; i++) {
+        history[i] = (unsigned char) ((history[i] >> 1) | (ref[i] ? 0x80 : 0));
+        ref[i] = 0;
+    }
+}
+
+/* History of frame i as it would be after a tick now, so that a page
+ * referenced since the last tick ranks above one that was not.
+ */
+static inline unsigned char aged(const unsigned char *history,
+                                 const unsigned char *ref, int i) {
+    return (unsigned char) ((history[i] >> 1) | (ref[i] ? 0x80 : 0));
+}
+
+/* Smallest aged history of frames [0, n).
+ */
+static unsigned char aging_min(const unsigned char *history,
+                               const unsigned char *ref, int n) {
+    unsigned char min = 0xff;
+    int i = 0;
+
+#ifdef __SSE2__
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i low7 = _mm_set1_epi8(0x7f);
+    const __m128i top = _mm_set1_epi8((char) 0x80);
+    __m128i m = _mm_set1_epi8((char) 0xff);
+    for (; i + 16 <= n; i += 16) {
+        __m128i h = _mm_loadu_si128((const __m128i *) (history + i));
+        __m128i r = _mm_loadu_si128((const __m128i *) (ref + i));
+        h = _mm_and_si128(_mm_srli_epi16(h, 1), low7);
+        h = _mm_or_si128(h, _mm_andnot_si128(_mm_cmpeq_epi8(r, zero), top));
+        m = _mm_min_epu8(m, h);
+    }
+    // Fold the 16 lanes down to one
+    m = _mm_min_epu8(m, _mm_srli_si128(m, 8));
+    m = _mm_min_epu8(m, _mm_srli_si128(m, 4));
+    m = _mm_min_epu8(m, _mm_srli_si128(m, 2));
+    m = _mm_min_epu8(m, _mm_srli_si128(m, 1));
+    min = (unsigned char) _mm_cvtsi128_si32(m);
+#endif
+    for (; i < n; i++) {
+        if (aged(history, ref, i) < min) {
+            min = aged(history, ref, i);
+        }
+    }
+    return min;
+}
+
+/* First frame in [from, to) whose aged history is value, or -1.
+ */
+static int aging_find(const unsigned char *history, const unsigned char *ref,
+                      int from, int to, unsigned char value) {
+    int i = from;
+
+#ifdef __SSE2__
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i low7 = _mm_set1_epi8(0x7f);
+    const __m128i top = _mm_set1_epi8((char) 0x80);
+    const __m128i v = _mm_set1_epi8((char) value);
+    for (; i + 16 <= to; i += 16) {
+        __m128i h = _mm_loadu_si128((const __m128i *) (history + i));
+        __m128i r = _mm_loadu_si128((const __m128i *) (ref + i));
+        h = _mm_and_si128(_mm_srli_epi16(h, 1), low7);
+        h = _mm_or_si128(h, _mm_andnot_si128(_mm_cmpeq_epi8(r, zero), top));
+        int mask = _mm_movemask_epi8(_mm_cmpeq_epi8(h, v));
+        if (mask != 0) {
+            return i + __builtin_ctz((unsigned int) mask);
+        }
+    }
+#endif
+    for (; i < to; i++) {
+        if (aged(history, ref, i) == value) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+/* Page to evict is the one with the smallest history; ties go to the
+ * first one from the hand on, which then moves past it.
+ * Returns the slot in the coremap that held the page that
+ * was evicted.
+ */
+int aging_evict(struct sim *s) {
+    struct aging *aging = s->alg_data;
+    unsigned char *ref = s->coremap.ref;
+    unsigned char min = aging_min(aging->history, ref, s->memsize);
+
+    int slot = aging_find(aging->history, ref, aging->hand, s->memsize, min);
+    if (slot == -1) {
+        slot = aging_find(aging->history, ref, 0, aging->hand, min);
+    }
+    assert(slot != -1);
+
+    // The page coming in starts with no history
+    aging->history[slot] = 0;
+    aging->hand = (slot == s->memsize - 1 ? 0 : slot + 1);
+    return slot;
+}
+
+/* Set the reference bit on every access, and tick when it is time.
+ */
+void aging_reference(struct sim *s, int frame) {
+    struct aging *aging = s->alg_data;
+
+    s->coremap.ref[frame] = 1;
+    if (s->ref_count >= aging->next_tick) {
+        aging_tick(s, aging);
+        aging->next_tick = s->ref_count + aging->period;
+    }
+}
+
+/* Initialize any data structures needed for this replacement
+ * algorithm
+ */
+void aging_init(struct sim *s) {
+    struct aging *aging = malloc(sizeof(struct aging));
+    if (aging == NULL) {
+        perror("Malloc failed");
+        exit(1);
+    }
+    aging->history = calloc((size_t) s->memsize, sizeof(unsigned char));
+    if (aging->history == NULL) {
+        perror("Malloc failed");
+        exit(1);
+    }
+    aging->period = s->params->window / 8 > 0 ? s->params->window / 8 : 1;
+    aging->next_tick = aging->period;
+    aging->hand = 0;
+    s->alg_data = aging;
+}
@@ -0,0 +1,153 @@
+#include <stdio.h>
+#include <unistd.h>
+#include <getopt.h>
+#include <stdlib.h>
+#include "pagetable.h"
+#include "trace.h"
+
+// Bit of each access type in the per-page type mask
+#define TYPE_BIT(type) ((type) == 'I' ? 1 : (type) == 'S' ? 2 : (type) == 'L' ? 4 : 8)
+
+// Histogram buckets: pages referenced [2^k, 2^(k+1)) times
+#define HIST_BUCKETS 64
+
+/* Summarize a valgrind lackey trace in a single pass: the number of
+ * distinct code and data pages, and the number of accesses before, in
+ * and after the region between the markers. The output is that of the
+ * old analyze_trace.rb. With -F, also print how often pages are
+ * referenced, as a histogram over powers of two.
+ */
+int main(int argc, char *argv[]) {
+    int opt;
+    char *tracefile = NULL;
+    char *markerfile = NULL;
+    int histogram = 0;
+    struct region region;
+    char *usage = "USAGE: analyze [-F] [-k markerfile] [tracefile] [marker_start marker_end]\n"
+                  "  the markers are hex addresses; -k reads them from a marker file\n"
+                  "  -F prints a histogram of references per page\n";
+
+    while ((opt = getopt(argc, argv, "k:F")) != -1) {
+        switch (opt) {
+        case 'k':
+            markerfile = optarg;
+            break;
+        case 'F':
+            histogram = 1;
+            break;
+        default:
+            fprintf(stderr, "%s", usage);
+            exit(1);
+        }
+    }
+
+    int args = argc - optind;
+    if (markerfile != NULL) {
+        if (args > 1) {
+            fprintf(stderr, "%s", usage);
+            exit(1);
+        }
+        if (!region_read(&region, markerfile)) {
+            perror("Error reading marker file:");
+            exit(1);
+        }
+    } else {
+        if (args < 2 || args > 3) {
+            fprintf(stderr, "%s", usage);
+            exit(1);
+        }
+        region.start = strtoul(argv[argc - 2], NULL, 16);
+        region.end = strtoul(argv[argc - 1], NULL, 16);
+        region.where = REGION_BEFORE;
+        args -= 2;
+    }
+    if (args == 1) {
+        tracefile = argv[optind];
+    }
+
+    struct trace *tfp;
+    if ((tfp = trace_open(tracefile)) == NULL) {
+        perror("Error opening tracefile:");
+        exit(1);
+    }
+    if (!trace_exact(tfp)) {
+        // The markers are single addresses, finer than a page
+        fprintf(stderr, "Error: markers need a text trace; binary traces "
+                        "only keep page numbers\n");
+        exit(1);
+    }
+
+    struct pageindex *index = pageindex_create(PAGE_SHIFT);
+    unsigned char *types = NULL;   // Access types seen on each page
+    unsigned long *counts = NULL;  // References to each page
+    unsigned int capacity = 0;
+    long accesses[REGION_AFTER + 1] = {0};
+    struct trace_ref ref;
+
+    while (trace_next(tfp, &ref)) {
+        unsigned int page = pageindex_page(index, ref.vaddr);
+        if (page >= capacity) {
+            unsigned int n = capacity ? capacity * 2 : 1 << 12;
+            types = realloc(types, n);
+            counts = realloc(counts, n * sizeof(unsigned long));
+            if (types == NULL || counts == NULL) {
+                perror("Malloc failed");
+                exit(1);
+            }
+            for (; capacity < n; capacity++) {
+                types[capacity] = 0;
+                counts[capacity] = 0;
+            }
+        }
+        types[page] |= TYPE_BIT(ref.type);
+        counts[page]++;
+        accesses[region_step(&region, ref.vaddr)]++;
+    }
+    trace_close(tfp);
+
+    long unique[4] = {0};        // I, S, L, M
+    unsigned int i;
+    int k;
+    for (i = 0; i < index->count; i++) {
+        for (k = 0; k < 4; k++) {
+            if (types[i] & (1 << k)) {
+                unique[k]++;
+            }
+        }
+    }
+
+    printf("Unique code pages (I):       : %20ld\n", unique[0]);
+    printf("Unique data pages (S + L + M): %20ld\n", unique[1] + unique[2] + unique[3]);
+    printf("                            S: %20ld\n", unique[1]);
+    printf("                            L: %20ld\n", unique[2]);
+    printf("                            M: %20ld\n", unique[3]);
+    printf("Memory accesses before\n"
+           "and after the markers:         %20ld\n",
+           accesses[REGION_BEFORE] + accesses[REGION_AFTER]);
+    printf("Memory accesses\n"
+           "in algorithm component:        %20ld\n", accesses[REGION_INSIDE]);
+
+    if (histogram) {
+        unsigned long pages[HIST_BUCKETS] = {0};
+        unsigned long refs[HIST_BUCKETS] = {0};
+        int top = 0;
+
+        for (i = 0; i < index->count; i++) {
+            int b = 63 - __builtin_clzl(counts[i]);
+            pages[b]++;
+            refs[b] += counts[i];
+            if (b > top) {
+                top = b;
+            }
+        }
+        printf("\nDistinct pages (code or data): %20ld\n", (long) index->count);
+        printf("%-24s %12s %16s\n", "References per page", "Pages", "References");
+        for (k = 0; k <= top; k++) {
+            char range[32];
+            snprintf(range, sizeof(range), "%lu-%lu", 1UL << k, (2UL << k) - 1);
+            printf("%-24s %12lu %16lu\n", range, pages[k], refs[k]);
+        }
+    }
+
+    return 0;
+}
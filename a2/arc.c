@@ -0,0 +1,158 @@
+#include <stdio.h>
+#include <assert.h>
+#include <unistd.h>
+#include <getopt.h>
+#include <stdlib.h>
+#include "sim.h"
+#include "pagelist.h"
+
+
+extern int debug;
+
+/* Adaptive Replacement Cache (Megiddo and Modha, FAST '03).
+ *
+ * Resident pages are split between T1 (seen once recently) and T2 (seen
+ * at least twice), both in LRU order. Pages evicted from T1 and T2 are
+ * remembered, without their data, in the ghost lists B1 and B2. A miss
+ * that hits a ghost list shows which of recency or frequency would have
+ * kept the page, and moves the target size p of T1 accordingly.
+ * T1 + B1 holds at most memsize pages and all four lists at most
+ * 2 * memsize, and every operation is O(1).
+ */
+
+enum { ARC_NONE, ARC_T1, ARC_T2, ARC_B1, ARC_B2 };
+
+struct arc {
+    struct pagelist list[5];  // Indexed by ARC_T1 .. ARC_B2
+    unsigned int *prev;       // List links, indexed by page number
+    unsigned int *next;
+    char *where;              // Which list each page is on
+    unsigned int npages;
+    int p;                    // Target size of T1
+};
+
+static void arc_grow(struct sim *s, struct arc *arc) {
+    if (arc->npages < s->npages) {
+        arc->prev = page_array_grow(arc->prev, sizeof(unsigned int),
+                                    arc->npages, s->npages, 0);
+        arc->next = page_array_grow(arc->next, sizeof(unsigned int),
+                                    arc->npages, s->npages, 0);
+        arc->where = page_array_grow(arc->where, sizeof(char),
+                                     arc->npages, s->npages, ARC_NONE);
+        arc->npages = s->npages;
+    }
+}
+
+/* Move page to the MRU end of list to.
+ */
+static void arc_move(struct arc *arc, unsigned int page, int to) {
+    if (arc->where[page] != ARC_NONE) {
+        pagelist_remove(&arc->list[(int) arc->where[page]], arc->prev,
+                        arc->next, page);
+    }
+    pagelist_push(&arc->list[to], arc->prev, arc->next, page);
+    arc->where[page] = (char) to;
+}
+
+/* Forget the LRU page of a ghost list.
+ */
+static void arc_discard(struct arc *arc, int from) {
+    unsigned int page = pagelist_pop(&arc->list[from], arc->prev, arc->next);
+    arc->where[page] = ARC_NONE;
+}
+
+/* The REPLACE routine of ARC: demote the LRU page of T1 or T2 to its
+ * ghost list and return the frame it occupied.
+ */
+static int arc_replace(struct sim *s, struct arc *arc, int in_b2) {
+    unsigned int t1 = arc->list[ARC_T1].size;
+    int from;
+
+    if (t1 >= 1 && (((int) t1 > arc->p) || (in_b2 && (int) t1 == arc->p) ||
+                    arc->list[ARC_T2].size == 0)) {
+        from = ARC_T1;
+    } else {
+        from = ARC_T2;
+    }
+    unsigned int victim = arc->list[from].head;
+    arc_move(arc, victim, from == ARC_T1 ? ARC_B1 : ARC_B2);
+
+    return s->pages[victim].pframe;
+}
+
+/* Page to evict is chosen using ARC. The page being faulted in is
+ * s->page; if it is on a ghost list, p adapts before the victim is picked.
+ * Returns the slot in the coremap that held the page that
+ * was evicted.
+ */
+int arc_evict(struct sim *s) {
+    struct arc *arc = s->alg_data;
+    arc_grow(s, arc);
+
+    int c = s->memsize;
+    int where = arc->where[s->page];
+    int t1 = arc->list[ARC_T1].size;
+    int t2 = arc->list[ARC_T2].size;
+    int b1 = arc->list[ARC_B1].size;
+    int b2 = arc->list[ARC_B2].size;
+
+    if (where == ARC_B1) {
+        // Recency would have helped: grow T1
+        int delta = b2 / b1 > 1 ? b2 / b1 : 1;
+        arc->p = arc->p + delta < c ? arc->p + delta : c;
+    } else if (where == ARC_B2) {
+        // Frequency would have helped: shrink T1
+        int delta = b1 / b2 > 1 ? b1 / b2 : 1;
+        arc->p = arc->p - delta > 0 ? arc->p - delta : 0;
+    } else if (t1 + b1 == c) {
+        if (t1 < c) {
+            arc_discard(arc, ARC_B1);
+        } else {
+            // B1 is empty and T1 fills memory: drop its LRU page outright
+            unsigned int victim = pagelist_pop(&arc->list[ARC_T1], arc->prev,
+                                               arc->next);
+            arc->where[victim] = ARC_NONE;
+            return s->pages[victim].pframe;
+        }
+    } else if (t1 + t2 + b1 + b2 >= 2 * c) {
+        arc_discard(arc, ARC_B2);
+    }
+
+    return arc_replace(s, arc, where == ARC_B2);
+}
+
+/* On a hit the page moves to the MRU end of T2. A page that has just been
+ * faulted in goes to T2 if it was remembered in a ghost list, otherwise
+ * to T1.
+ */
+void arc_reference(struct sim *s, int frame) {
+    struct arc *arc = s->alg_data;
+    arc_grow(s, arc);
+
+    unsigned int page = s->page;
+    int where = arc->where[page];
+
+    if (where == ARC_NONE) {
+        arc_move(arc, page, ARC_T1);
+    } else {
+        arc_move(arc, page, ARC_T2);
+    }
+}
+
+/* Initialize any data structures needed for this replacement
+ * algorithm
+ */
+void arc_init(struct sim *s) {
+    struct arc *arc = calloc(1, sizeof(struct arc));
+    if (arc == NULL) {
+        perror("Malloc failed");
+        exit(1);
+    }
+    int i;
+    for (i = 0; i < 5; i++) {
+        pagelist_init(&arc->list[i]);
+    }
+    arc->p = 0;
+    s->alg_data = arc;
+    arc_grow(s, arc);
+}
@@ -0,0 +1,268 @@
+#include <stdio.h>
+#include <unistd.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include "sim.h"
+
+/* Belady's anomaly search (sim -B): every algorithm runs with every
+ * memory size of a range on the decoded trace, and wherever one more
+ * frame brings more faults, a short trace showing the same is written
+ * out as a witness.
+ */
+
+// Witnesses longer than this are left at the shortest prefix
+#define WITNESS_REDUCE_MAX 2000
+
+/* Whether the references at positions seq[0..n) of refs fault more with
+ * memsize + 1 frames than with memsize.
+ */
+static int anomalous(struct functions *alg, int memsize,
+                     const struct sim_params *params, struct pageindex *index,
+                     const struct refs *refs, const long *seq, long n) {
+    struct sim small;
+    struct sim large;
+    long i;
+
+    sim_init(&small, alg, memsize, params, index, NULL);
+    sim_init(&large, alg, memsize + 1, params, index, NULL);
+    for (i = 0; i < n; i++) {
+        access_mem(&small, refs->page[seq[i]], refs->type[seq[i]]);
+        access_mem(&large, refs->page[seq[i]], refs->type[seq[i]]);
+    }
+    int found = large.miss_count > small.miss_count;
+    sim_free(&small);
+    sim_free(&large);
+    return found;
+}
+
+/* Shrink seq[0..*n) as long as it stays anomalous, by taking out ever
+ * smaller chunks of it (Zeller's ddmin). The result is 1-minimal once the
+ * chunks are single references: no one of them can go.
+ */
+static void reduce(struct functions *alg, int memsize,
+                   const struct sim_params *params, struct pageindex *index,
+                   const struct refs *refs, long *seq, long *n) {
+    long *rest = malloc(*n * sizeof(long));
+    long chunks = 2;
+
+    if (rest == NULL) {
+        perror("Malloc failed");
+        exit(1);
+    }
+    while (*n >= 2) {
+        long size = (*n + chunks - 1) / chunks;
+        int removed = 0;
+        long start;
+
+        for (start = 0; start < *n; start += size) {
+            long end = start + size < *n ? start + size : *n;
+            long m = 0;
+            long i;
+            for (i = 0; i < *n; i++) {
+                if (i < start || i >= end) {
+                    rest[m++] = seq[i];
+                }
+            }
+            if (anomalous(alg, memsize, params, index, refs, rest, m)) {
+                memcpy(seq, rest, m * sizeof(long));
+                *n = m;
+                removed = 1;
+                break;
+            }
+        }
+        if (removed) {
+            chunks = chunks > 2 ? chunks - 1 : 2;
+        } else if (size == 1) {
+            break;
+        } else {
+            chunks = chunks * 2 < *n ? chunks * 2 : *n;
+        }
+    }
+    free(rest);
+}
+
+/* Write the references at seq[0..n) as a valgrind lackey trace.
+ */
+static void write_witness(const char *path, const struct pageindex *index,
+                          const struct refs *refs, const long *seq, long n) {
+    FILE *fp = fopen(path, "w");
+    long i;
+
+    if (fp == NULL) {
+        perror("Error opening witness file:");
+        exit(1);
+    }
+    for (i = 0; i < n; i++) {
+        char type = refs->type[seq[i]];
+        addr_t vaddr = index->vaddrs[refs->page[seq[i]]];
+        fprintf(fp, type == 'I' ? "%c  %08lx,0\n" : " %c %08lx,0\n", type, vaddr);
+    }
+    if (fclose(fp) != 0) {
+        perror("Error writing witness file:");
+        exit(1);
+    }
+}
+
+/* Find the shortest prefix of the trace on which s faults less than
+ * with one frame more, reduce it, and write it to a file.
+ * Returns the length of the witness.
+ */
+static long witness(struct sim *smaller, const struct sim_params *params,
+                    struct pageindex *index, const struct refs *refs,
+                    const char *path) {
+    struct sim small;
+    struct sim large;
+    long *seq = malloc(refs->count * sizeof(long));
+    long n = 0;
+
+    if (seq == NULL) {
+        perror("Malloc failed");
+        exit(1);
+    }
+    sim_init(&small, smaller->alg, smaller->memsize, params, index, NULL);
+    sim_init(&large, smaller->alg, smaller->memsize + 1, params, index, NULL);
+    while (n < refs->count && large.miss_count <= small.miss_count) {
+        access_mem(&small, refs->page[n], refs->type[n]);
+        access_mem(&large, refs->page[n], refs->type[n]);
+        seq[n] = n;
+        n++;
+    }
+    sim_free(&small);
+    sim_free(&large);
+
+    /* The references just before the extra fault matter most, so first
+     * look for a short tail of the prefix that shows the anomaly on its
+     * own, from empty memory.
+     */
+    long tail;
+    for (tail = 256; tail < n; tail *= 2) {
+        if (anomalous(smaller->alg, smaller->memsize, params, index, refs,
+                      seq + n - tail, tail)) {
+            memmove(seq, seq + n - tail, tail * sizeof(long));
+            n = tail;
+            break;
+        }
+    }
+    // Then move its start on for as long as that keeps it
+    long step;
+    for (step = n / 2; step > 0; step /= 2) {
+        while (step < n && anomalous(smaller->alg, smaller->memsize, params,
+                                     index, refs, seq + step, n - step)) {
+            memmove(seq, seq + step, (n - step) * sizeof(long));
+            n -= step;
+        }
+    }
+    if (n <= WITNESS_REDUCE_MAX) {
+        reduce(smaller->alg, smaller->memsize, params, index, refs, seq, &n);
+    }
+    write_witness(path, index, refs, seq, n);
+    free(seq);
+    return n;
+}
+
+/* An anomaly between s and the simulation with one frame more.
+ */
+struct anomaly {
+    struct sim *s;
+    char path[64];
+    long length;            // Of the witness
+};
+
+/* Anomalies waiting for a worker thread to find their witness, like the
+ * simulations of struct pool.
+ */
+struct witness_pool {
+    struct anomaly *anomalies;
+    int count;
+    int next;
+    pthread_mutex_t lock;
+    const struct sim_params *params;
+    struct pageindex *index;
+    const struct refs *refs;
+};
+
+static void *witness_worker(void *arg) {
+    struct witness_pool *pool = arg;
+    int i;
+
+    while (1) {
+        pthread_mutex_lock(&pool->lock);
+        i = pool->next++;
+        pthread_mutex_unlock(&pool->lock);
+        if (i >= pool->count) {
+            break;
+        }
+        struct anomaly *a = &pool->anomalies[i];
+        a->length = witness(a->s, pool->params, pool->index, pool->refs,
+                            a->path);
+    }
+    return NULL;
+}
+
+/* Report every step of the sims (nalgs runs of nsizes memory sizes each,
+ * in increasing order, one frame apart) where the faults go up, with a
+ * witness trace for each. The witnesses are found on nthreads threads.
+ */
+void belady_report(struct sim *sims, int nalgs, int nsizes,
+                   const struct sim_params *params, struct pageindex *index,
+                   const struct refs *refs, int nthreads) {
+    int tty = 0 <= tcgetpgrp(STDOUT_FILENO);
+    struct witness_pool pool = {NULL, 0, 0, PTHREAD_MUTEX_INITIALIZER,
+                                params, index, refs};
+    int i, j;
+
+    for (j = 0; j < nalgs; j++) {
+        for (i = 0; i + 1 < nsizes; i++) {
+            struct sim *s = &sims[j * nsizes + i];
+            if (s[1].miss_count <= s->miss_count) {
+                continue;
+            }
+            pool.anomalies = realloc(pool.anomalies,
+                                     (pool.count + 1) * sizeof(struct anomaly));
+            if (pool.anomalies == NULL) {
+                perror("Malloc failed");
+                exit(1);
+            }
+            struct anomaly *a = &pool.anomalies[pool.count++];
+            a->s = s;
+            snprintf(a->path, sizeof(a->path), "belady-%s-%d.trace",
+                     s->alg->name, s->memsize);
+        }
+    }
+
+    pthread_t *threads = malloc(nthreads * sizeof(pthread_t));
+    if (threads == NULL) {
+        perror("Malloc failed");
+        exit(1);
+    }
+    // The main thread is one of the workers
+    for (i = 1; i < nthreads; i++) {
+        if (pthread_create(&threads[i], NULL, witness_worker, &pool) != 0) {
+            perror("pthread_create");
+            exit(1);
+        }
+    }
+    witness_worker(&pool);
+    for (i = 1; i < nthreads; i++) {
+        pthread_join(threads[i], NULL);
+    }
+    free(threads);
+
+    printf("\n");
+    if (tty) {
+        printf("%-10s %8s %12s %12s %10s  %s\n", "Algorithm", "Memsize",
+               "Misses", "Misses + 1", "Witness", "File");
+    }
+    for (i = 0; i < pool.count; i++) {
+        struct anomaly *a = &pool.anomalies[i];
+        printf(tty ? "%-10s %8d %12ld %12ld %10ld  %s\n"
+                   : "%s %d %ld %ld %ld %s\n",
+               a->s->alg->name, a->s->memsize, a->s->miss_count,
+               a->s[1].miss_count, a->length, a->path);
+    }
+    if (tty && pool.count == 0) {
+        printf("No anomaly found\n");
+    }
+    free(pool.anomalies);
+}
@@ -0,0 +1,137 @@
+#ifndef BINTRACE_H
+#define BINTRACE_H
+
+#include <stdio.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+/* Compact binary trace format.
+ *
+ * A file starts with a struct bintrace_header and is followed by one
+ * varint (7 bits per byte, least significant group first) per memory
+ * reference:
+ *
+ *     tag = zigzag(page - previous page of the same stream) << 2 | type
+ *
+ * where type is 0 = I, 1 = L, 2 = S, 3 = M. Instruction fetches and data
+ * accesses are delta-encoded against separate previous pages (stream 0
+ * and 1), so a reference to the same page as the last one of its kind
+ * costs a single byte. Only page numbers are kept: the offset within the
+ * page and the access length are dropped, and the header says so with
+ * BINTRACE_PAGES. Readers that need exact addresses, such as marker
+ * regions and cache simulation, have to refuse such a trace (see
+ * trace_exact). Traces written before the flag existed lack it but hold
+ * page numbers just the same.
+ *
+ * All header fields are stored in host byte order.
+ */
+
+#define BINTRACE_MAGIC "A2BTRACE"
+#define BINTRACE_VERSION 1
+#define BINTRACE_PAGE_SHIFT 12
+#define BINTRACE_VARINT_MAX 10
+
+// Header flags
+#define BINTRACE_PAGES 0x1     // No in-page offsets or access lengths
+
+struct bintrace_header {
+    char magic[8];
+    uint16_t version;
+    uint16_t page_shift;   // Page numbers are vaddr >> page_shift
+    uint32_t flags;        // BINTRACE_ flags
+    uint64_t count;        // Number of references, 0 if unknown
+};
+
+static const char bintrace_types[4] = {'I', 'L', 'S', 'M'};
+
+/* Map a lackey access type to its 2-bit code.
+ */
+static inline unsigned int bintrace_type_code(char type) {
+    switch (type) {
+    case 'L':
+        return 1;
+    case 'S':
+        return 2;
+    case 'M':
+        return 3;
+    default:
+        return 0;
+    }
+}
+
+/* Buffered encoder used by trace2bin and by the instrumented kernels.
+ */
+struct bintrace_writer {
+    FILE *fp;
+    uint64_t prev[2];      // Previous page of the I and data streams
+    uint64_t count;
+    size_t len;
+    unsigned char buf[1 << 16];
+};
+
+static inline void bintrace_flush(struct bintrace_writer *w) {
+    if (w->len > 0 && fwrite(w->buf, 1, w->len, w->fp) != w->len) {
+        perror("Error writing binary trace:");
+    }
+    w->len = 0;
+}
+
+static inline void bintrace_header_init(struct bintrace_header *h,
+                                        uint64_t count) {
+    memset(h, 0, sizeof(*h));
+    memcpy(h->magic, BINTRACE_MAGIC, sizeof(h->magic));
+    h->version = BINTRACE_VERSION;
+    h->page_shift = BINTRACE_PAGE_SHIFT;
+    h->flags = BINTRACE_PAGES;
+    h->count = count;
+}
+
+static inline void bintrace_writer_init(struct bintrace_writer *w, FILE *fp) {
+    struct bintrace_header h;
+
+    memset(w, 0, offsetof(struct bintrace_writer, buf));
+    w->fp = fp;
+    bintrace_header_init(&h, 0);
+    memcpy(w->buf, &h, sizeof(h));
+    w->len = sizeof(h);
+}
+
+static inline void bintrace_put(struct bintrace_writer *w, char type,
+                                uint64_t vaddr) {
+    unsigned int code = bintrace_type_code(type);
+    int stream = code != 0;
+    uint64_t page = vaddr >> BINTRACE_PAGE_SHIFT;
+    int64_t delta = (int64_t) (page - w->prev[stream]);
+    uint64_t tag = ((((uint64_t) delta) << 1) ^ (uint64_t) (delta >> 63)) << 2
+                   | code;
+
+    if (w->len > sizeof(w->buf) - BINTRACE_VARINT_MAX) {
+        bintrace_flush(w);
+    }
+    while (tag >= 0x80) {
+        w->buf[w->len++] = (unsigned char) (tag | 0x80);
+        tag >>= 7;
+    }
+    w->buf[w->len++] = (unsigned char) tag;
+    w->prev[stream] = page;
+    w->count++;
+}
+
+/* Flush the remaining records and, if the output is seekable, fill in
+ * the reference count in the header.
+ */
+static inline void bintrace_finish(struct bintrace_writer *w) {
+    struct bintrace_header h;
+
+    bintrace_flush(w);
+    fflush(w->fp);
+    bintrace_header_init(&h, w->count);
+    if (fseek(w->fp, 0, SEEK_SET) == 0) {
+        fwrite(&h, sizeof(h), 1, w->fp);
+        fseek(w->fp, 0, SEEK_END);
+    }
+    fflush(w->fp);
+}
+
+#endif
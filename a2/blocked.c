@@ -4,7 +4,7 @@
  * Purpose:  Compare the run time of the standard matrix multiplication
  *           algorithm with blocked matrix multiplication.
  *
- * Compile:  gcc -g -Wall -I. [-DDEBUG] -o blocked blocked.c
+ * Compile:  gcc -g -Wall -I. [-DDEBUG] [-DMEMTRACE] -o blocked blocked.c
  * Run:      ./blocked <order of matrices> <order of blocks> [i]
  *              <-> required argument, [-] optional argument
  *
@@ -49,6 +49,7 @@
 #include <stdlib.h>
 #include <string.h> // for memset
 #include "timer.h"
+#include "memtrace.h"
 
 #define PAD 120
 
@@ -101,6 +102,8 @@ int main(int argc, char* argv[]) {
 
    n_bar = n/b;
    b_sqr = b*b;
+   // With -DMEMTRACE, the accesses to the matrices are traced
+   MEMTRACE_START("blocked.bin");
    Get_matrices(A, B, n, argc);
 
 #  ifdef DEBUG
@@ -110,6 +113,7 @@ int main(int argc, char* argv[]) {
    GET_TIME(start2);
    Blocked_mat_mult();
    GET_TIME(finish2);
+   MEMTRACE_STOP();
 #  ifdef DEBUG 
    printf("Blocked algorithm\n");
    From_blocked(C, n, b);
@@ -151,7 +155,9 @@ void Get_matrices(struct record A[], struct record B[], int n, int argc) {
    int i;
 
    for (i = 0; i < n*n; i++) {
+       MEMTRACE_STORE(&A[i]);
        A[i].value = random()/DRAND_MAX;
+       MEMTRACE_STORE(&B[i]);
        B[i].value = random()/DRAND_MAX;
    }
 }  /* Get_matrices */
@@ -170,6 +176,7 @@ void Get_matrices(struct record A[], struct record B[], int n, int argc) {
 void Zero_C(int i_bar, int j_bar) {
    C_p = C + (i_bar*n_bar + j_bar)*b_sqr;
 
+   MEMTRACE_STORES(C_p, b_sqr);
    memset(C_p, 0, b_sqr*sizeof(struct record));
 }  /* Zero_C */
 
@@ -196,9 +203,13 @@ void Mult_add(int i_bar, int j_bar, int k_bar) {
 
    for (i = 0; i < b; i++)
       for (j = 0; j < b; j++) 
-         for (k = 0; k < b; k++)
+         for (k = 0; k < b; k++) {
+            MEMTRACE_LOAD(a_p + i*b + k);
+            MEMTRACE_LOAD(b_p + k*b + j);
+            MEMTRACE_MODIFY(c_p + i*b + j);
             (*(c_p + i*b + j)).value += 
                (*(a_p + i*b+k)).value*(*(b_p + k*b + j)).value;
+         }
 }  /* Mult_add */
 
 /*-------------------------------------------------------------------
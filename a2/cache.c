@@ -0,0 +1,235 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "cache.h"
+
+struct cache *cache_create(const char *name, unsigned long size,
+                           unsigned int ways, unsigned int line_shift) {
+    struct cache *c = calloc(1, sizeof(struct cache));
+    if (c == NULL) {
+        perror("Malloc failed");
+        exit(1);
+    }
+    snprintf(c->name, sizeof(c->name), "%s", name);
+    c->ways = ways;
+    c->sets = (unsigned int) ((size >> line_shift) / ways);
+    c->tags = calloc((size_t) c->sets * ways, sizeof(addr_t));
+    c->stamp = calloc((size_t) c->sets * ways, sizeof(unsigned long));
+    c->dirty = calloc((size_t) c->sets * ways, 1);
+    if (c->tags == NULL || c->stamp == NULL || c->dirty == NULL) {
+        perror("Malloc failed");
+        exit(1);
+    }
+    return c;
+}
+
+/* Entry of c holding line, or -1.
+ */
+static long cache_find(struct cache *c, addr_t line) {
+    long base = (long) (line % c->sets) * c->ways;
+    unsigned int i;
+
+    for (i = 0; i < c->ways; i++) {
+        if (c->tags[base + i] == line + 1) {
+            return base + i;
+        }
+    }
+    return -1;
+}
+
+/* Cache at level i for an access of the given type.
+ */
+static struct cache *level(struct hierarchy *h, int i, char type) {
+    return i == 0 && type == 'I' ? h->l1i : h->levels[i];
+}
+
+static void insert(struct hierarchy *h, int i, char type, addr_t line,
+                   int dirty);
+
+/* Drop line from c if it is there. Returns whether it was dirty.
+ */
+static int invalidate(struct cache *c, addr_t line) {
+    long e = cache_find(c, line);
+    int dirty;
+
+    if (e < 0) {
+        return 0;
+    }
+    dirty = c->dirty[e];
+    c->tags[e] = 0;
+    c->stamp[e] = 0;
+    c->dirty[e] = 0;
+    return dirty;
+}
+
+/* Write the dirty line back below level i, to the first level that holds
+ * it or else to memory. Nothing is allocated on the way.
+ */
+static void write_back(struct hierarchy *h, int i, addr_t line) {
+    for (i++; i < h->nlevels; i++) {
+        long e = cache_find(h->levels[i], line);
+        if (e >= 0) {
+            h->levels[i]->dirty[e] = 1;
+            return;
+        }
+    }
+    h->mem_writes++;
+}
+
+/* Look for line in the levels below i on a miss in an exclusive
+ * hierarchy. A level that holds it gives it up, since it moves to i.
+ * Returns whether the line was dirty.
+ */
+static int take(struct hierarchy *h, int i, addr_t line) {
+    for (i++; i < h->nlevels; i++) {
+        struct cache *c = h->levels[i];
+
+        c->accesses++;
+        if (cache_find(c, line) >= 0) {
+            return invalidate(c, line);
+        }
+        c->misses++;
+    }
+    h->mem_reads++;
+    return 0;
+}
+
+/* Access line at level i and below. Writes are only passed down when
+ * the hierarchy is write-through or the write does not allocate.
+ */
+static void access_line(struct hierarchy *h, int i, char type, addr_t line,
+                        int write) {
+    if (i == h->nlevels) {
+        if (write) {
+            h->mem_writes++;
+        } else {
+            h->mem_reads++;
+        }
+        return;
+    }
+
+    struct cache *c = level(h, i, type);
+    long e = cache_find(c, line);
+
+    c->accesses++;
+    c->clock++;
+    if (e >= 0) {
+        c->stamp[e] = c->clock;
+        if (write) {
+            if (h->write_back) {
+                c->dirty[e] = 1;
+            } else {
+                access_line(h, i + 1, type, line, 1);
+            }
+        }
+        return;
+    }
+    c->misses++;
+
+    if (write && !h->write_allocate) {
+        access_line(h, i + 1, type, line, 1);
+        return;
+    }
+
+    int dirty = 0;
+    if (h->inclusion == CACHE_EXCLUSIVE) {
+        dirty = take(h, i, line);
+    } else {
+        access_line(h, i + 1, type, line, 0);
+    }
+    if (write) {
+        if (h->write_back) {
+            dirty = 1;
+        } else {
+            access_line(h, i + 1, type, line, 1);
+        }
+    }
+    insert(h, i, type, line, dirty);
+}
+
+/* Put line into level i, evicting the LRU line of its set.
+ */
+static void insert(struct hierarchy *h, int i, char type, addr_t line,
+                   int dirty) {
+    struct cache *c = level(h, i, type);
+    long base = (long) (line % c->sets) * c->ways;
+    long e = base;
+    unsigned int w;
+
+    // invalid entries have stamp 0, so they are used first
+    for (w = 1; w < c->ways; w++) {
+        if (c->stamp[base + w] < c->stamp[e]) {
+            e = base + w;
+        }
+    }
+
+    if (c->tags[e] != 0) {
+        addr_t victim = c->tags[e] - 1;
+        int victim_dirty = c->dirty[e];
+        int j;
+
+        // an inclusive level takes its copies out of the levels above
+        if (h->inclusion == CACHE_INCLUSIVE) {
+            for (j = 0; j < i; j++) {
+                victim_dirty |= invalidate(h->levels[j], victim);
+            }
+            if (i > 0 && h->l1i != h->levels[0]) {
+                victim_dirty |= invalidate(h->l1i, victim);
+            }
+        }
+
+        if (victim_dirty) {
+            c->writebacks++;
+        }
+        if (h->inclusion == CACHE_EXCLUSIVE) {
+            // the next level is a victim cache for this one
+            if (i + 1 < h->nlevels) {
+                insert(h, i + 1, 'D', victim, victim_dirty);
+            } else if (victim_dirty) {
+                h->mem_writes++;
+            }
+        } else if (victim_dirty) {
+            write_back(h, i, victim);
+        }
+    }
+
+    c->clock++;
+    c->tags[e] = line + 1;
+    c->stamp[e] = c->clock;
+    c->dirty[e] = (char) dirty;
+}
+
+/* Simulate one trace reference, which touches every line it overlaps.
+ * A modify (M) reads the line and then writes it.
+ */
+void hierarchy_access(struct hierarchy *h, char type, addr_t vaddr,
+                      unsigned int length) {
+    addr_t first = vaddr >> h->line_shift;
+    addr_t last = (vaddr + (length ? length : 1) - 1) >> h->line_shift;
+    addr_t line;
+
+    for (line = first; line <= last; line++) {
+        access_line(h, 0, type, line, type == 'S');
+        if (type == 'M') {
+            access_line(h, 0, type, line, 1);
+        }
+    }
+}
+
+/* Forget the counts so far but keep the contents of the caches, at the
+ * start of a region of interest.
+ */
+void hierarchy_reset_stats(struct hierarchy *h) {
+    int i;
+
+    for (i = 0; i < h->nlevels; i++) {
+        h->levels[i]->accesses = 0;
+        h->levels[i]->misses = 0;
+        h->levels[i]->writebacks = 0;
+    }
+    h->l1i->accesses = 0;
+    h->l1i->misses = 0;
+    h->l1i->writebacks = 0;
+    h->mem_reads = 0;
+    h->mem_writes = 0;
+}
@@ -0,0 +1,51 @@
+#ifndef CACHE_H
+#define CACHE_H
+
+#include "pagetable.h"
+
+/* A hierarchy of set-associative CPU caches with LRU replacement, all
+ * with the same line size. Level 0 can be split into an instruction and
+ * a data cache; the levels below are unified. Misses in the last level
+ * go to memory.
+ */
+
+#define CACHE_MAX_LEVELS 4
+
+enum { CACHE_INCLUSIVE, CACHE_EXCLUSIVE, CACHE_NINE };
+
+struct cache {
+    char name[8];
+    unsigned int sets;
+    unsigned int ways;
+    addr_t *tags;           // Line number + 1 of each entry, 0 if invalid;
+                            // set i is tags[i * ways .. + ways)
+    unsigned long *stamp;   // Last use of each entry
+    char *dirty;
+    unsigned long clock;
+
+    long accesses;
+    long misses;
+    long writebacks;        // Dirty lines written to the next level
+};
+
+struct hierarchy {
+    struct cache *levels[CACHE_MAX_LEVELS];  // levels[0] is the L1 data
+    struct cache *l1i;      // L1 instruction cache, levels[0] if unified
+    int nlevels;
+    unsigned int line_shift;
+
+    int write_back;         // Otherwise write-through
+    int write_allocate;     // Otherwise writes that miss bypass the cache
+    int inclusion;          // CACHE_INCLUSIVE, CACHE_EXCLUSIVE or CACHE_NINE
+
+    long mem_reads;
+    long mem_writes;
+};
+
+struct cache *cache_create(const char *name, unsigned long size,
+                           unsigned int ways, unsigned int line_shift);
+void hierarchy_access(struct hierarchy *h, char type, addr_t vaddr,
+                      unsigned int length);
+void hierarchy_reset_stats(struct hierarchy *h);
+
+#endif
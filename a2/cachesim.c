@@ -0,0 +1,220 @@
+#include <stdio.h>
+#include <unistd.h>
+#include <getopt.h>
+#include <stdlib.h>
+#include <string.h>
+#include "pagetable.h"
+#include "trace.h"
+#include "cache.h"
+
+/* Parse a size with an optional K, M or G suffix.
+ */
+static unsigned long parse_size(const char *arg, char **end) {
+    unsigned long size = strtoul(arg, end, 10);
+
+    switch (**end) {
+    case 'G': case 'g':
+        size <<= 10;
+        /* fall through */
+    case 'M': case 'm':
+        size <<= 10;
+        /* fall through */
+    case 'K': case 'k':
+        size <<= 10;
+        (*end)++;
+    }
+    return size;
+}
+
+static int log2_exact(unsigned long n) {
+    int shift = 0;
+
+    if (n == 0 || (n & (n - 1)) != 0) {
+        return -1;
+    }
+    while ((1UL << shift) < n) {
+        shift++;
+    }
+    return shift;
+}
+
+static void print_level(struct cache *c, int tty) {
+    printf(tty ? "%-8s %14ld %14ld %10.4f %12ld\n" : "%s %ld %ld %.4f %ld\n",
+           c->name, c->accesses, c->misses,
+           c->accesses ? (double) c->misses / c->accesses * 100 : 0.0,
+           c->writebacks);
+}
+
+/* Simulate a hierarchy of set-associative CPU caches on a lackey trace,
+ * using the address and length of every access, and print the miss rate
+ * of each level over the whole trace or over the region between the
+ * markers (-k).
+ */
+int main(int argc, char *argv[]) {
+    int opt;
+    char *tracefile = NULL;
+    char *markerfile = NULL;
+    char *configs[CACHE_MAX_LEVELS];
+    int nconfigs = 0;
+    unsigned long line = 64;
+    int split = 0;
+    struct hierarchy h;
+    char *usage = "USAGE: cachesim [-f tracefile] [-c size:ways ...] [-l linesize] [-s]\n"
+                  "                [-W wb|wt] [-A alloc|noalloc] [-I incl|excl|nine] [-k markerfile]\n"
+                  "  -c gives one level per use, from L1 down (default 32K:8 256K:8 8M:16)\n"
+                  "  -s splits L1 into instruction and data caches of that size\n";
+
+    memset(&h, 0, sizeof(h));
+    h.write_back = 1;
+    h.write_allocate = 1;
+    h.inclusion = CACHE_INCLUSIVE;
+
+    while ((opt = getopt(argc, argv, "f:c:l:sW:A:I:k:")) != -1) {
+        switch (opt) {
+        case 'f':
+            tracefile = optarg;
+            break;
+        case 'c':
+            if (nconfigs == CACHE_MAX_LEVELS) {
+                fprintf(stderr, "Error: at most %d cache levels\n",
+                        CACHE_MAX_LEVELS);
+                exit(1);
+            }
+            configs[nconfigs++] = optarg;
+            break;
+        case 'l':
+            line = strtoul(optarg, NULL, 10);
+            break;
+        case 's':
+            split = 1;
+            break;
+        case 'W':
+            h.write_back = strcmp(optarg, "wt") != 0;
+            break;
+        case 'A':
+            h.write_allocate = strcmp(optarg, "noalloc") != 0;
+            break;
+        case 'I':
+            if (strcmp(optarg, "incl") == 0) {
+                h.inclusion = CACHE_INCLUSIVE;
+            } else if (strcmp(optarg, "excl") == 0) {
+                h.inclusion = CACHE_EXCLUSIVE;
+            } else if (strcmp(optarg, "nine") == 0) {
+                h.inclusion = CACHE_NINE;
+            } else {
+                fprintf(stderr, "%s", usage);
+                exit(1);
+            }
+            break;
+        case 'k':
+            markerfile = optarg;
+            break;
+        default:
+            fprintf(stderr, "%s", usage);
+            exit(1);
+        }
+    }
+
+    if (log2_exact(line) < 0) {
+        fprintf(stderr, "Error: invalid line size - %lu\n", line);
+        exit(1);
+    }
+    h.line_shift = (unsigned int) log2_exact(line);
+    if (h.inclusion == CACHE_EXCLUSIVE && !h.write_back) {
+        // write-through would need the line in the next level
+        fprintf(stderr, "Error: exclusive caches must be write-back\n");
+        exit(1);
+    }
+
+    if (nconfigs == 0) {
+        configs[nconfigs++] = strdup("32K:8");
+        configs[nconfigs++] = strdup("256K:8");
+        configs[nconfigs++] = strdup("8M:16");
+    }
+    int i;
+    for (i = 0; i < nconfigs; i++) {
+        char *end;
+        unsigned long size = parse_size(configs[i], &end);
+        unsigned long ways = *end == ':' ? strtoul(end + 1, &end, 10) : 1;
+        char name[8];
+
+        if (*end != '\0' || ways == 0 || size < line * ways ||
+            log2_exact(size / line / ways) < 0) {
+            fprintf(stderr, "Error: invalid cache - %s\n", configs[i]);
+            exit(1);
+        }
+        snprintf(name, sizeof(name), i == 0 && split ? "L1d" : "L%d", i + 1);
+        h.levels[i] = cache_create(name, size, (unsigned int) ways,
+                                   h.line_shift);
+        if (i == 0) {
+            h.l1i = split ? cache_create("L1i", size, (unsigned int) ways,
+                                         h.line_shift)
+                          : h.levels[0];
+        }
+    }
+    h.nlevels = nconfigs;
+
+    struct region region;
+    if (markerfile != NULL && !region_read(&region, markerfile)) {
+        perror("Error reading marker file:");
+        exit(1);
+    }
+
+    struct trace *tfp;
+    if ((tfp = trace_open(tracefile)) == NULL) {
+        perror("Error opening tracefile:");
+        exit(1);
+    }
+    if (!trace_exact(tfp)) {
+        fprintf(stderr, "Error: cachesim needs a text trace; binary traces "
+                        "only keep page numbers\n");
+        exit(1);
+    }
+
+    struct trace_ref ref;
+    long refs = 0;
+    while (trace_next(tfp, &ref)) {
+        if (markerfile != NULL) {
+            int where = region_step(&region, ref.vaddr);
+            if (where == REGION_START) {
+                // warm caches, fresh counts
+                hierarchy_reset_stats(&h);
+                refs = 0;
+                continue;
+            }
+            if (where == REGION_AFTER) {
+                break;
+            }
+        }
+        hierarchy_access(&h, ref.type, ref.vaddr, ref.length);
+        refs++;
+    }
+    trace_close(tfp);
+
+    if (markerfile != NULL && region.where == REGION_BEFORE) {
+        fprintf(stderr, "Error: start marker not found in trace\n");
+        exit(1);
+    }
+
+    int tty = 0 <= tcgetpgrp(STDOUT_FILENO);
+    if (tty) {
+        printf("\n%ld references%s\n\n", refs,
+               markerfile != NULL ? " between the markers" : "");
+        printf("%-8s %14s %14s %10s %12s\n", "Level", "Accesses", "Misses",
+               "Miss rate", "Write-backs");
+    }
+    if (h.l1i != h.levels[0]) {
+        print_level(h.l1i, tty);
+    }
+    for (i = 0; i < h.nlevels; i++) {
+        print_level(h.levels[i], tty);
+    }
+    if (tty) {
+        printf("\nMemory reads:      %ld\n", h.mem_reads);
+        printf("Memory writes:     %ld\n", h.mem_writes);
+    } else {
+        printf("memory %ld %ld\n", h.mem_reads, h.mem_writes);
+    }
+
+    return 0;
+}
@@ -0,0 +1,165 @@
+#include <stdio.h>
+#include <assert.h>
+#include <unistd.h>
+#include <getopt.h>
+#include <stdlib.h>
+#include "sim.h"
+#include "pagelist.h"
+
+
+extern int debug;
+
+/* CLOCK with Adaptive Replacement (Bansal and Modha, FAST '04).
+ *
+ * CAR keeps ARC's split of resident pages into T1 (recency) and T2
+ * (frequency) and its ghost lists B1 and B2, but T1 and T2 are clocks:
+ * a hit only sets the page's reference bit, and pages are only moved
+ * when the hand sweeps past them during replacement. The target size p
+ * of T1 adapts on ghost hits exactly as in ARC.
+ */
+
+enum { CAR_NONE, CAR_T1, CAR_T2, CAR_B1, CAR_B2 };
+
+struct car {
+    struct pagelist list[5];  // Indexed by CAR_T1 .. CAR_B2
+    unsigned int *prev;       // List links, indexed by page number
+    unsigned int *next;
+    char *where;              // Which list each page is on
+    char *ref;                // Reference bit of resident pages
+    unsigned int npages;
+    int p;                    // Target size of T1
+};
+
+static void car_grow(struct sim *s, struct car *car) {
+    if (car->npages < s->npages) {
+        car->prev = page_array_grow(car->prev, sizeof(unsigned int),
+                                    car->npages, s->npages, 0);
+        car->next = page_array_grow(car->next, sizeof(unsigned int),
+                                    car->npages, s->npages, 0);
+        car->where = page_array_grow(car->where, sizeof(char),
+                                     car->npages, s->npages, CAR_NONE);
+        car->ref = page_array_grow(car->ref, sizeof(char),
+                                   car->npages, s->npages, 0);
+        car->npages = s->npages;
+    }
+}
+
+/* Move page to the tail of list to (the MRU end, or just behind the hand
+ * for the clocks).
+ */
+static void car_move(struct car *car, unsigned int page, int to) {
+    if (car->where[page] != CAR_NONE) {
+        pagelist_remove(&car->list[(int) car->where[page]], car->prev,
+                        car->next, page);
+    }
+    pagelist_push(&car->list[to], car->prev, car->next, page);
+    car->where[page] = (char) to;
+}
+
+static void car_discard(struct car *car, int from) {
+    unsigned int page = pagelist_pop(&car->list[from], car->prev, car->next);
+    car->where[page] = CAR_NONE;
+}
+
+/* Page to evict is chosen using CAR. Sweep the T1 clock while T1 is over
+ * its target size, otherwise the T2 clock, until a page with a clear
+ * reference bit is found. Referenced T1 pages are promoted to T2.
+ * Returns the slot in the coremap that held the page that
+ * was evicted.
+ */
+int car_evict(struct sim *s) {
+    struct car *car = s->alg_data;
+    car_grow(s, car);
+
+    unsigned int victim;
+    while (1) {
+        int t1 = car->list[CAR_T1].size;
+        if (t1 >= (car->p > 1 ? car->p : 1)) {
+            unsigned int head = car->list[CAR_T1].head;
+            if (!car->ref[head]) {
+                victim = head;
+                car_move(car, head, CAR_B1);
+                break;
+            }
+            car->ref[head] = 0;
+            car_move(car, head, CAR_T2);
+        } else {
+            unsigned int head = car->list[CAR_T2].head;
+            if (!car->ref[head]) {
+                victim = head;
+                car_move(car, head, CAR_B2);
+                break;
+            }
+            car->ref[head] = 0;
+            car_move(car, head, CAR_T2);
+        }
+    }
+
+    // Keep the directory within 2 * memsize pages
+    int where = car->where[s->page];
+    if (where != CAR_B1 && where != CAR_B2) {
+        int c = s->memsize;
+        int t1 = car->list[CAR_T1].size;
+        int t2 = car->list[CAR_T2].size;
+        int b1 = car->list[CAR_B1].size;
+        int b2 = car->list[CAR_B2].size;
+        if (t1 + b1 == c && b1 > 0) {
+            car_discard(car, CAR_B1);
+        } else if (t1 + t2 + b1 + b2 == 2 * c && b2 > 0) {
+            car_discard(car, CAR_B2);
+        }
+    }
+
+    return s->pages[victim].pframe;
+}
+
+/* A hit only sets the reference bit. A page that has just been faulted
+ * in joins T1, or T2 if it was remembered in a ghost list, in which case
+ * p adapts as in ARC.
+ */
+void car_reference(struct sim *s, int frame) {
+    struct car *car = s->alg_data;
+    car_grow(s, car);
+
+    unsigned int page = s->page;
+    int where = car->where[page];
+    int c = s->memsize;
+    int b1 = car->list[CAR_B1].size;
+    int b2 = car->list[CAR_B2].size;
+
+    if (where == CAR_T1 || where == CAR_T2) {
+        car->ref[page] = 1;
+        return;
+    }
+
+    if (where == CAR_B1) {
+        int delta = b2 / b1 > 1 ? b2 / b1 : 1;
+        car->p = car->p + delta < c ? car->p + delta : c;
+        car_move(car, page, CAR_T2);
+    } else if (where == CAR_B2) {
+        int delta = b1 / b2 > 1 ? b1 / b2 : 1;
+        car->p = car->p - delta > 0 ? car->p - delta : 0;
+        car_move(car, page, CAR_T2);
+    } else {
+        car_move(car, page, CAR_T1);
+    }
+    car->ref[page] = 0;
+}
+
+/* Initialize any data structures needed for this replacement
+ * algorithm
+ */
+void car_init(struct sim *s) {
+    struct car *car = calloc(1, sizeof(struct car));
+    if (car == NULL) {
+        perror("Malloc failed");
+        exit(1);
+    }
+    int i;
+    for (i = 0; i < 5; i++) {
+        pagelist_init(&car->list[i]);
+    }
+    car->p = 0;
+    s->alg_data = car;
+    car_grow(s, car);
+}
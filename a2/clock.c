@@ -3,52 +3,63 @@
 #include <unistd.h>
 #include <getopt.h>
 #include <stdlib.h>
-#include "pagetable.h"
+#include "sim.h"
 
 
-extern int memsize;
-
 extern int debug;
 
-extern struct frame *coremap;
-
-// clock hand
-static int hand;
+struct clock {
+    // clock hand
+    int hand;
+};
 
 /* Page to evict is chosen using the accurate clock algorithm 
  * Returns the slot in the coremap that held the page that
  * was evicted.
  */
 
-int clock_evict() {
+int clock_evict(struct sim *s) {
+    struct clock *clock = s->alg_data;
+    struct coremap *coremap = &s->coremap;
+    int hand = clock->hand;
+
     // choose a frame slot to evict a page from
     int slot = -1;
 
     // find the first frame with reference bit unset
     while (1) {
-        if (!coremap[hand].ref) {
+        if (!coremap->ref[hand]) {
             slot = hand;
             break;
         }
 
         // ref bit was set; unset it
-        coremap[hand].ref = 0;
+        coremap->ref[hand] = 0;
 
         // advance the hand
-        hand = (hand == memsize - 1 ? 0 : hand + 1);
+        hand = (hand == s->memsize - 1 ? 0 : hand + 1);
     }
 
-    // find the victim page in the pagetable and mark
-    // it as not in memory
-    struct page *victim = find_page(coremap[slot].vaddr);
-    victim->pframe = -1;
-
+    clock->hand = hand;
     return slot;
 }
 
 /* Initialize any data structures needed for this replacement
  * algorithm 
  */
-void clock_init() {
-    hand = 0;
+void clock_init(struct sim *s) {
+    struct clock *clock = malloc(sizeof(struct clock));
+    if (clock == NULL) {
+        perror("Malloc failed");
+        exit(1);
+    }
+    clock->hand = 0;
+    s->alg_data = clock;
+}
+
+/* Set the reference bit on every access, not just when the page is loaded.
+ * Used by eclock; clock itself only sets it when the page is loaded.
+ */
+void clock_reference(struct sim *s, int frame) {
+    s->coremap.ref[frame] = 1;
 }
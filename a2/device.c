@@ -0,0 +1,109 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include "device.h"
+
+/* Parse a -d argument of the form read:write[:bandwidth[:depth]] into c,
+ * with latencies in microseconds and bandwidth in MB/s.
+ * Returns 0 if it is not valid.
+ */
+int device_parse(struct device_config *c, char *arg) {
+    char *end;
+
+    c->read_latency = strtod(arg, &end) * 1000;
+    if (*end != ':') {
+        return 0;
+    }
+    c->write_latency = strtod(end + 1, &end) * 1000;
+    c->bandwidth = 0;
+    c->depth = 1;
+    if (*end == ':') {
+        // 1 MB/s is 1e-3 bytes per ns
+        c->bandwidth = strtod(end + 1, &end) / 1000;
+        if (*end == ':') {
+            c->depth = (int) strtol(end + 1, &end, 10);
+        }
+    }
+    return *end == '\0' && c->read_latency > 0 && c->write_latency >= 0 &&
+           c->bandwidth >= 0 && c->depth > 0;
+}
+
+struct device *device_create(const struct device_config *c) {
+    struct device *d = calloc(1, sizeof(struct device));
+    if (d == NULL) {
+        perror("Malloc failed");
+        exit(1);
+    }
+    d->busy_until = calloc(c->depth, sizeof(double));
+    if (d->busy_until == NULL) {
+        perror("Malloc failed");
+        exit(1);
+    }
+    d->config = c;
+    return d;
+}
+
+void device_free(struct device *d) {
+    free(d->busy_until);
+    free(d);
+}
+
+/* Queue a request of the given latency and size at the current time.
+ * Returns when it completes.
+ */
+static double issue(struct device *d, double latency, unsigned long bytes) {
+    const struct device_config *c = d->config;
+    int slot = 0;
+    int i;
+
+    for (i = 1; i < c->depth; i++) {
+        if (d->busy_until[i] < d->busy_until[slot]) {
+            slot = i;
+        }
+    }
+    double service = latency + (c->bandwidth > 0 ? bytes / c->bandwidth : 0);
+    double start = d->busy_until[slot] > d->now ? d->busy_until[slot] : d->now;
+    d->busy_until[slot] = start + service;
+    d->busy += service;
+    return start + service;
+}
+
+/* Read a page in; the program waits for it.
+ */
+void device_read(struct device *d, unsigned long bytes) {
+    device_wait(d, issue(d, d->config->read_latency, bytes));
+}
+
+/* Read a page ahead, in the background. Returns when it will be in.
+ */
+double device_prefetch(struct device *d, unsigned long bytes) {
+    return issue(d, d->config->read_latency, bytes);
+}
+
+/* Stop the program until time done, if it has not passed yet.
+ */
+void device_wait(struct device *d, double done) {
+    if (done > d->now) {
+        d->stall += done - d->now;
+        d->now = done;
+    }
+}
+
+/* Write a page back in the background.
+ */
+void device_write(struct device *d, unsigned long bytes) {
+    issue(d, d->config->write_latency, bytes);
+}
+
+/* Remember the times at the start of the marker region (see sim_mark).
+ */
+void device_mark(struct device *d) {
+    d->mark[0] = d->now;
+    d->mark[1] = d->busy;
+    d->mark[2] = d->stall;
+}
+
+void device_unmark(struct device *d) {
+    d->now -= d->mark[0];
+    d->busy -= d->mark[1];
+    d->stall -= d->mark[2];
+}
@@ -0,0 +1,48 @@
+#ifndef DEVICE_H
+#define DEVICE_H
+
+/* A model of the swap device behind memory, to turn faults into time.
+ * The program runs for ref_ns per reference and stops at each fault
+ * until the page has been read in. Write-backs of dirty victims are
+ * issued without waiting, and proceed alongside the program and other
+ * I/O, as do reads of pages read ahead until the program uses them.
+ * The device serves up to depth requests at once, each taking its
+ * latency plus the transfer at the given bandwidth; a request that
+ * finds every slot busy queues for the first to free up.
+ * All times are in nanoseconds.
+ */
+
+struct device_config {
+    double read_latency;    // 0 if there is no device model
+    double write_latency;
+    double bandwidth;       // Bytes per ns, 0 for no transfer time
+    int depth;              // Requests in service at once
+    double ref_ns;          // Time of a reference that does not fault
+};
+
+struct device {
+    const struct device_config *config;
+    double *busy_until;     // When each of the depth slots frees up
+    double now;             // Time the program has reached
+    double busy;            // Sum of the service times of all requests
+    double stall;           // Time the program spent waiting for reads
+    double mark[3];         // now, busy and stall at device_mark
+};
+
+int device_parse(struct device_config *c, char *arg);
+struct device *device_create(const struct device_config *c);
+void device_free(struct device *d);
+void device_read(struct device *d, unsigned long bytes);
+void device_write(struct device *d, unsigned long bytes);
+double device_prefetch(struct device *d, unsigned long bytes);
+void device_wait(struct device *d, double done);
+void device_mark(struct device *d);
+void device_unmark(struct device *d);
+
+/* Let n references go by without a fault.
+ */
+static inline void device_run(struct device *d, long n) {
+    d->now += n * d->config->ref_ns;
+}
+
+#endif
@@ -0,0 +1,70 @@
+#include <stdio.h>
+#include <assert.h>
+#include <unistd.h>
+#include <getopt.h>
+#include <stdlib.h>
+#include "sim.h"
+
+
+extern int debug;
+
+/* Enhanced second chance: the clock algorithm over the classes formed by
+ * the reference and dirty bits. In order of preference the victim is
+ *   (0, 0) not recently used, clean
+ *   (0, 1) not recently used, dirty
+ *   (1, 0) recently used, clean
+ *   (1, 1) recently used, dirty
+ * so a clean page is thrown out before a dirty one that would have to be
+ * written back first.
+ */
+
+struct eclock {
+    // clock hand
+    int hand;
+};
+
+/* Page to evict is chosen using the enhanced second chance algorithm.
+ * Returns the slot in the coremap that held the page that
+ * was evicted.
+ */
+
+int eclock_evict(struct sim *s) {
+    struct eclock *eclock = s->alg_data;
+    struct coremap *coremap = &s->coremap;
+    int hand = eclock->hand;
+    int i;
+
+    while (1) {
+        // look for (0, 0) without touching any bits
+        for (i = 0; i < s->memsize; i++) {
+            if (!coremap->ref[hand] && !coremap->dirty[hand]) {
+                eclock->hand = (hand == s->memsize - 1 ? 0 : hand + 1);
+                return hand;
+            }
+            hand = (hand == s->memsize - 1 ? 0 : hand + 1);
+        }
+
+        // look for (0, 1), clearing reference bits on the way
+        for (i = 0; i < s->memsize; i++) {
+            if (!coremap->ref[hand]) {
+                eclock->hand = (hand == s->memsize - 1 ? 0 : hand + 1);
+                return hand;
+            }
+            coremap->ref[hand] = 0;
+            hand = (hand == s->memsize - 1 ? 0 : hand + 1);
+        }
+    }
+}
+
+/* Initialize any data structures needed for this replacement
+ * algorithm
+ */
+void eclock_init(struct sim *s) {
+    struct eclock *eclock = malloc(sizeof(struct eclock));
+    if (eclock == NULL) {
+        perror("Malloc failed");
+        exit(1);
+    }
+    eclock->hand = 0;
+    s->alg_data = eclock;
+}
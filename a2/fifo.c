@@ -3,31 +3,27 @@
 #include <unistd.h>
 #include <getopt.h>
 #include <stdlib.h>
-#include "pagetable.h"
+#include "sim.h"
 
 
-extern int memsize;
-
 extern int debug;
 
-extern struct frame *coremap;
-
-// Keep track of the index of the oldest page
-static int first_in;
+struct fifo {
+    // Keep track of the index of the oldest page
+    int first_in;
+};
 
 /* Page to evict is chosen using the fifo algorithm
  * Returns the slot in the coremap that held the page that
  * was evicted.
  */
 
-int fifo_evict(void) {
-    // choose a frame slot to evict a page from
-    int slot = first_in = (first_in == memsize - 1 ? 0 : first_in + 1);
+int fifo_evict(struct sim *s) {
+    struct fifo *fifo = s->alg_data;
 
-    // find the victim page in the pagetable and mark
-    // it as not in memory
-    struct page *victim = find_page(coremap[slot].vaddr);
-    victim->pframe = -1;
+    // choose a frame slot to evict a page from
+    int slot = fifo->first_in =
+        (fifo->first_in == s->memsize - 1 ? 0 : fifo->first_in + 1);
 
     return slot;
 }
@@ -35,6 +31,12 @@ int fifo_evict(void) {
 /* Initialize any data structures needed for this 
  * replacement algorithm 
  */
-void fifo_init() {
-    first_in = -1;
+void fifo_init(struct sim *s) {
+    struct fifo *fifo = malloc(sizeof(struct fifo));
+    if (fifo == NULL) {
+        perror("Malloc failed");
+        exit(1);
+    }
+    fifo->first_in = -1;
+    s->alg_data = fifo;
 }
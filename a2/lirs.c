@@ -0,0 +1,202 @@
+#include <stdio.h>
+#include <assert.h>
+#include <unistd.h>
+#include <getopt.h>
+#include <stdlib.h>
+#include "sim.h"
+#include "pagelist.h"
+
+
+extern int debug;
+
+/* Low Inter-reference Recency Set (Jiang and Zhang, SIGMETRICS '02).
+ *
+ * Pages whose last two references were close together (LIR pages) hold
+ * all but 1% of the frames. The remaining frames hold HIR pages, kept
+ * in the FIFO queue Q, and the victim is always the front of Q. The
+ * stack S orders LIR pages and recently seen HIR pages (resident or not)
+ * by recency, and is pruned so that its bottom is always a LIR page. An
+ * HIR page referenced again while still in S has a shorter reuse
+ * distance than the oldest LIR page, and takes its place.
+ *
+ * Non-resident HIR pages in S are also linked, oldest first, on the list
+ * nonres, which reuses the Q links (a non-resident page is never in Q).
+ * It is bounded at twice the number of frames.
+ */
+
+enum { LIRS_NONE, LIRS_LIR, LIRS_HIR, LIRS_NONRES };
+
+struct lirs {
+    struct pagelist stack;    // S, bottom = head
+    struct pagelist queue;    // Q, front = head
+    struct pagelist nonres;   // Non-resident HIR pages in S, oldest first
+    unsigned int *sprev;      // Links of S, indexed by page number
+    unsigned int *snext;
+    unsigned int *qprev;      // Links of Q and nonres
+    unsigned int *qnext;
+    char *status;             // LIRS_LIR, LIRS_HIR (resident) or LIRS_NONRES
+    char *in_stack;
+    unsigned int npages;
+    unsigned int lir_count;
+    unsigned int lir_max;     // Frames for LIR pages
+    unsigned int nonres_max;
+};
+
+static void lirs_grow(struct sim *s, struct lirs *l) {
+    if (l->npages < s->npages) {
+        l->sprev = page_array_grow(l->sprev, sizeof(unsigned int),
+                                   l->npages, s->npages, 0);
+        l->snext = page_array_grow(l->snext, sizeof(unsigned int),
+                                   l->npages, s->npages, 0);
+        l->qprev = page_array_grow(l->qprev, sizeof(unsigned int),
+                                   l->npages, s->npages, 0);
+        l->qnext = page_array_grow(l->qnext, sizeof(unsigned int),
+                                   l->npages, s->npages, 0);
+        l->status = page_array_grow(l->status, sizeof(char),
+                                    l->npages, s->npages, LIRS_NONE);
+        l->in_stack = page_array_grow(l->in_stack, sizeof(char),
+                                      l->npages, s->npages, 0);
+        l->npages = s->npages;
+    }
+}
+
+static void stack_remove(struct lirs *l, unsigned int page) {
+    pagelist_remove(&l->stack, l->sprev, l->snext, page);
+    l->in_stack[page] = 0;
+    if (l->status[page] == LIRS_NONRES) {
+        pagelist_remove(&l->nonres, l->qprev, l->qnext, page);
+        l->status[page] = LIRS_NONE;
+    }
+}
+
+/* Move page to the top of S.
+ */
+static void stack_top(struct lirs *l, unsigned int page) {
+    if (l->in_stack[page]) {
+        pagelist_remove(&l->stack, l->sprev, l->snext, page);
+    }
+    pagelist_push(&l->stack, l->sprev, l->snext, page);
+    l->in_stack[page] = 1;
+}
+
+/* Remove HIR pages from the bottom of S until a LIR page is there.
+ */
+static void stack_prune(struct lirs *l) {
+    while (l->stack.size > 0 && l->status[l->stack.head] != LIRS_LIR) {
+        stack_remove(l, l->stack.head);
+    }
+}
+
+/* Turn the LIR page at the bottom of S into a resident HIR page at the
+ * end of Q.
+ */
+static void demote_bottom(struct lirs *l) {
+    stack_prune(l);
+    unsigned int page = l->stack.head;
+    stack_remove(l, page);
+    l->status[page] = LIRS_HIR;
+    l->lir_count--;
+    pagelist_push(&l->queue, l->qprev, l->qnext, page);
+    stack_prune(l);
+}
+
+/* Page to evict is chosen using LIRS: the resident HIR page at the front
+ * of Q. If it is still in S it is kept there as a non-resident page.
+ * Returns the slot in the coremap that held the page that
+ * was evicted.
+ */
+int lirs_evict(struct sim *s) {
+    struct lirs *l = s->alg_data;
+    lirs_grow(s, l);
+
+    unsigned int victim;
+    if (l->queue.size > 0) {
+        victim = pagelist_pop(&l->queue, l->qprev, l->qnext);
+        if (l->in_stack[victim]) {
+            l->status[victim] = LIRS_NONRES;
+            pagelist_push(&l->nonres, l->qprev, l->qnext, victim);
+            if (l->nonres.size > l->nonres_max) {
+                stack_remove(l, l->nonres.head);
+            }
+        } else {
+            l->status[victim] = LIRS_NONE;
+        }
+    } else {
+        // Every resident page is LIR: fall back to the bottom LIR page
+        stack_prune(l);
+        victim = l->stack.head;
+        stack_remove(l, victim);
+        l->status[victim] = LIRS_NONE;
+        l->lir_count--;
+        stack_prune(l);
+    }
+
+    return s->pages[victim].pframe;
+}
+
+void lirs_reference(struct sim *s, int frame) {
+    struct lirs *l = s->alg_data;
+    lirs_grow(s, l);
+
+    unsigned int page = s->page;
+    switch (l->status[page]) {
+    case LIRS_LIR:
+        stack_top(l, page);
+        stack_prune(l);
+        break;
+    case LIRS_HIR:
+        if (l->in_stack[page]) {
+            // Reused within the LIR set's recency: becomes LIR
+            pagelist_remove(&l->queue, l->qprev, l->qnext, page);
+            stack_top(l, page);
+            l->status[page] = LIRS_LIR;
+            l->lir_count++;
+            demote_bottom(l);
+        } else {
+            stack_top(l, page);
+            pagelist_remove(&l->queue, l->qprev, l->qnext, page);
+            pagelist_push(&l->queue, l->qprev, l->qnext, page);
+        }
+        break;
+    default:
+        // The page has just been faulted in
+        if (l->lir_count < l->lir_max && l->status[page] == LIRS_NONE) {
+            // Still filling the LIR set
+            stack_top(l, page);
+            l->status[page] = LIRS_LIR;
+            l->lir_count++;
+        } else if (l->status[page] == LIRS_NONRES) {
+            pagelist_remove(&l->nonres, l->qprev, l->qnext, page);
+            stack_top(l, page);
+            l->status[page] = LIRS_LIR;
+            l->lir_count++;
+            if (l->lir_count > l->lir_max) {
+                demote_bottom(l);
+            }
+        } else {
+            stack_top(l, page);
+            l->status[page] = LIRS_HIR;
+            pagelist_push(&l->queue, l->qprev, l->qnext, page);
+        }
+        break;
+    }
+}
+
+/* Initialize any data structures needed for this replacement
+ * algorithm. HIR pages get 1% of the frames, and at least one.
+ */
+void lirs_init(struct sim *s) {
+    struct lirs *l = calloc(1, sizeof(struct lirs));
+    if (l == NULL) {
+        perror("Malloc failed");
+        exit(1);
+    }
+    pagelist_init(&l->stack);
+    pagelist_init(&l->queue);
+    pagelist_init(&l->nonres);
+    unsigned int hir = s->memsize / 100 > 1 ? s->memsize / 100 : 1;
+    l->lir_max = (unsigned int) s->memsize > hir ? s->memsize - hir : 0;
+    l->nonres_max = 2 * s->memsize;
+    s->alg_data = l;
+    lirs_grow(s, l);
+}
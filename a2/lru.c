@@ -3,34 +3,35 @@
 #include <unistd.h>
 #include <getopt.h>
 #include <stdlib.h>
-#include "pagetable.h"
+#include "sim.h"
 
 
-extern int memsize;
-
 extern int debug;
 
-extern struct frame *coremap;
-
-// Keep a global time counter
-static unsigned long counter;
+struct lru {
+    // Keep a global time counter
+    unsigned long counter;
+};
 
 /* Page to evict is chosen using the accurate LRU algorithm 
  * Returns the slot in the coremap that held the page that
  * was evicted.
  */
 
-int lru_evict() {
+int lru_evict(struct sim *s) {
+    struct lru *lru = s->alg_data;
+    struct coremap *coremap = &s->coremap;
+
     // choose a frame slot to evict a page from
     int slot = -1;
 
     // find the frame with the earliest timestamp
-    unsigned long min = counter;
+    unsigned long min = lru->counter;
     int i;
-    for (i = 0; i < memsize; i++) {
-        if (coremap[i].stamp < min) {
+    for (i = 0; i < s->memsize; i++) {
+        if (coremap->stamp[i] < min) {
             slot = i;
-            min = coremap[i].stamp;
+            min = coremap->stamp[i];
         }
     }
 
@@ -39,24 +40,26 @@ int lru_evict() {
         exit(1);
     }
 
-    // find the victim page in the pagetable and mark
-    // it as not in memory
-    struct page *victim = find_page(coremap[slot].vaddr);
-    victim->pframe = -1;
-
     return slot;
 }
 
 /* When a page frame is referenced, update its timestamp
  */
-void lru_reference(int frame) {
-    coremap[frame].stamp = counter++;
+void lru_reference(struct sim *s, int frame) {
+    struct lru *lru = s->alg_data;
+    s->coremap.stamp[frame] = lru->counter++;
 }
 
 
 /* Initialize any data structures needed for this 
  * replacement algorithm 
  */
-void lru_init() {
-    counter = 0;
+void lru_init(struct sim *s) {
+    struct lru *lru = malloc(sizeof(struct lru));
+    if (lru == NULL) {
+        perror("Malloc failed");
+        exit(1);
+    }
+    lru->counter = 0;
+    s->alg_data = lru;
 }
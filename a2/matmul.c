@@ -3,7 +3,7 @@
  *
  * Purpose:  Run a standard matrix multiply
  *
- * Compile:  gcc -g -Wall [-DDEBUG] -o matmul matmul.c
+ * Compile:  gcc -g -Wall [-DDEBUG] [-DMEMTRACE] -o matmul matmul.c
  * Run:      ./matmul <order of matrices>
  *              <-> required argument, [-] optional argument
  *
@@ -30,6 +30,7 @@
 #include <stdlib.h>
 #include <string.h> // for memset
 #include "timer.h"
+#include "memtrace.h"
 
 #define PAD 120
 
@@ -65,11 +66,14 @@ int main(int argc, char* argv[]) {
       exit(-1);
    }
 
+   // With -DMEMTRACE, the accesses to the matrices are traced
+   MEMTRACE_START("matmul.bin");
    Get_matrices(A, B, n);
 
    GET_TIME(start1);
    Mat_mult();
    GET_TIME(finish1);
+   MEMTRACE_STOP();
 #  ifdef DEBUG 
    printf("Standard algorithm\n");
    Print_matrix(C, n);
@@ -107,7 +111,9 @@ void Get_matrices(struct record A[], struct record B[], int n ) {
    int i;
 
       for (i = 0; i < n*n; i++) {
+         MEMTRACE_STORE(&A[i]);
          A[i].value = random()/DRAND_MAX;
+         MEMTRACE_STORE(&B[i]);
          B[i].value = random()/DRAND_MAX;
       }
 }  /* Get_matrices */
@@ -125,9 +131,14 @@ void Mat_mult(void) {
 
    for (i = 0; i < n; i++) {
       for (j = 0; j < n; j++) {
+         MEMTRACE_STORE(&C[i*n + j]);
          C[i*n + j].value = 0.0;
-         for (k = 0; k < n; k++)
+         for (k = 0; k < n; k++) {
+            MEMTRACE_LOAD(&A[i*n + k]);
+            MEMTRACE_LOAD(&B[k*n + j]);
+            MEMTRACE_MODIFY(&C[i*n + j]);
             C[i*n + j].value += A[i*n + k].value * B[k*n + j].value;
+         }
       }
    }
 }  /* Mat_mult */
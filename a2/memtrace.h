@@ -0,0 +1,96 @@
+#ifndef MEMTRACE_H
+#define MEMTRACE_H
+
+/* Tracing shim for the kernels (simpleloop, matmul, blocked). Built
+ * with -DMEMTRACE, a kernel writes the accesses it makes to its arrays
+ * straight to a binary trace (see bintrace.h) as it runs, instead of
+ * being run under valgrind --tool=lackey. Only the accesses named with
+ * the macros below between MEMTRACE_START and MEMTRACE_STOP are traced:
+ * there are no instruction fetches and no accesses to locals, so the
+ * trace holds the reference string of the data alone.
+ *
+ * The trace goes to the file named by MEMTRACE_FILE in the environment,
+ * or else to the one given to MEMTRACE_START. Without -DMEMTRACE the
+ * macros do nothing.
+ */
+
+#ifdef MEMTRACE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include "bintrace.h"
+
+static struct bintrace_writer *memtrace_writer;
+
+static inline void memtrace_start(const char *path) {
+    const char *env = getenv("MEMTRACE_FILE");
+    FILE *fp;
+
+    if (env != NULL) {
+        path = env;
+    }
+    if ((fp = fopen(path, "wb")) == NULL) {
+        perror("Error opening trace file:");
+        exit(1);
+    }
+    memtrace_writer = malloc(sizeof(struct bintrace_writer));
+    if (memtrace_writer == NULL) {
+        perror("Malloc failed");
+        exit(1);
+    }
+    bintrace_writer_init(memtrace_writer, fp);
+}
+
+static inline void memtrace_stop(void) {
+    if (memtrace_writer == NULL) {
+        return;
+    }
+    bintrace_finish(memtrace_writer);
+    if (fclose(memtrace_writer->fp) != 0) {
+        perror("Error writing trace file:");
+        exit(1);
+    }
+    free(memtrace_writer);
+    memtrace_writer = NULL;
+}
+
+/* Record an access of the given lackey type at p, if tracing is on.
+ */
+static inline void memtrace_put(char type, const volatile void *p) {
+    if (memtrace_writer != NULL) {
+        bintrace_put(memtrace_writer, type, (uint64_t) (uintptr_t) p);
+    }
+}
+
+/* Record n accesses of the given type, size bytes apart from p on, as
+ * a memset or memcpy of n elements would make.
+ */
+static inline void memtrace_range(char type, const volatile void *p,
+                                  size_t n, size_t size) {
+    size_t i;
+
+    for (i = 0; i < n; i++) {
+        memtrace_put(type, (const volatile char *) p + i * size);
+    }
+}
+
+#define MEMTRACE_START(path) memtrace_start(path)
+#define MEMTRACE_STOP() memtrace_stop()
+#define MEMTRACE_LOAD(p) memtrace_put('L', (p))
+#define MEMTRACE_STORE(p) memtrace_put('S', (p))
+#define MEMTRACE_MODIFY(p) memtrace_put('M', (p))
+#define MEMTRACE_STORES(p, n) memtrace_range('S', (p), (n), sizeof(*(p)))
+
+#else
+
+#define MEMTRACE_START(path) ((void) 0)
+#define MEMTRACE_STOP() ((void) 0)
+#define MEMTRACE_LOAD(p) ((void) 0)
+#define MEMTRACE_STORE(p) ((void) 0)
+#define MEMTRACE_MODIFY(p) ((void) 0)
+#define MEMTRACE_STORES(p, n) ((void) 0)
+
+#endif
+
+#endif
@@ -0,0 +1,174 @@
+#include <stdio.h>
+#include <unistd.h>
+#include <getopt.h>
+#include <stdlib.h>
+#include "pagetable.h"
+#include "trace.h"
+#include "stackdist.h"
+#include "shards.h"
+
+/* Print the curve estimated from the sample in the same format as the
+ * exact one, and with compare, how far it is from the exact curve.
+ */
+static void print_estimate(struct shards *sh, struct stackdist *sd,
+                           unsigned int maxmem, int compare) {
+    int tty = 0 <= tcgetpgrp(STDOUT_FILENO);
+    unsigned long exact_hits = 0;
+    double max_error = 0;
+    double sum_error = 0;
+    unsigned int m;
+    // Below 1/R frames, distances are finer than the sample can resolve
+    unsigned int resolution = (unsigned int) (1 / shards_rate(sh) + 0.5);
+
+    if (tty) {
+        printf("\n%-10s %8s %12s %12s %16s %10s %10s\n", "Algorithm",
+               "Memsize", "Hits", "Misses", "Total refs", "Hit rate",
+               "Miss rate");
+    }
+    for (m = 1; m <= maxmem; m++) {
+        double ratio = shards_miss_ratio(sh, m);
+        unsigned long misses = (unsigned long) (ratio * sh->refs + 0.5);
+        unsigned long hits = sh->refs - misses;
+        printf(tty ? "%-10s %8u %12lu %12lu %16lu %10.4f %10.4f\n"
+                   : "%s %u %lu %lu %lu %.4f %.4f\n",
+               "lru", m, hits, misses, sh->refs,
+               (double) hits / sh->refs * 100,
+               (double) misses / sh->refs * 100);
+
+        if (compare) {
+            if (m <= sd->maxdist) {
+                exact_hits += sd->hist[m];
+            }
+            double error = ratio - (double) (sd->refs - exact_hits) / sd->refs;
+            error = error < 0 ? -error : error;
+            sum_error += error;
+            if (m >= resolution && error > max_error) {
+                max_error = error;
+            }
+        }
+    }
+    fprintf(stderr, "Sampled %lu of %lu references at final rate %.6f\n",
+            sh->samples, sh->refs, shards_rate(sh));
+    if (compare) {
+        fprintf(stderr, "Miss ratio error: mean %.4f, max %.4f from %u frames"
+                " (percentage points)\n", sum_error / maxmem * 100,
+                max_error * 100, resolution);
+    }
+}
+
+/* Print the LRU miss-ratio curve of a trace: the result sim -a lru would
+ * give for every memory size from 1 up to the point where only cold
+ * misses remain (or -m memsize), computed in a single pass.
+ *
+ * With -R, only a hashed sample of the pages is tracked (see shards.h)
+ * and the curve is an estimate; -S bounds the number of sampled pages by
+ * lowering the rate as needed. -E also computes the exact curve and
+ * reports the error of the estimate on standard error.
+ */
+int main(int argc, char *argv[]) {
+    int opt;
+    char *tracefile = NULL;
+    unsigned int maxmem = 0;
+    double rate = 0;
+    unsigned int smax = 0;
+    int compare = 0;
+    char *usage = "USAGE: mrc [-f tracefile] [-m max memorysize] [-R rate [-S maxpages] [-E]]\n";
+
+    while ((opt = getopt(argc, argv, "f:m:R:S:E")) != -1) {
+        switch (opt) {
+        case 'f':
+            tracefile = optarg;
+            break;
+        case 'm':
+            maxmem = (unsigned int) strtoul(optarg, NULL, 10);
+            break;
+        case 'R':
+            rate = strtod(optarg, NULL);
+            if (rate <= 0 || rate > 1) {
+                fprintf(stderr, "Error: invalid sampling rate - %s\n", optarg);
+                exit(1);
+            }
+            break;
+        case 'S':
+            smax = (unsigned int) strtoul(optarg, NULL, 10);
+            break;
+        case 'E':
+            compare = 1;
+            break;
+        default:
+            fprintf(stderr, "%s", usage);
+            exit(1);
+        }
+    }
+
+    struct trace *tfp;
+    if ((tfp = trace_open(tracefile)) == NULL) {
+        perror("Error opening tracefile:");
+        exit(1);
+    }
+
+    if (rate == 0 && (smax > 0 || compare)) {
+        fprintf(stderr, "%s", usage);
+        exit(1);
+    }
+
+    // The exact curve, unless only the sampled one is wanted
+    int exact = rate == 0 || compare;
+    struct pageindex *index = pageindex_create(PAGE_SHIFT);
+    struct stackdist *sd = stackdist_create();
+    struct shards *sh = rate > 0 ? shards_create(rate, smax) : NULL;
+    struct trace_ref ref;
+    long refs = 0;
+    while (trace_next(tfp, &ref)) {
+        refs++;
+        if (exact) {
+            stackdist_access(sd, pageindex_page(index, ref.vaddr));
+        }
+        if (sh != NULL) {
+            shards_access(sh, ref.vaddr);
+        }
+    }
+    trace_close(tfp);
+
+    // There is no miss ratio without references
+    if (refs == 0) {
+        fprintf(stderr, "Error: empty trace\n");
+        exit(1);
+    }
+
+    if (maxmem == 0) {
+        unsigned long maxdist = sh != NULL ? sh->maxdist : sd->maxdist;
+        maxmem = maxdist > 0 ? (unsigned int) maxdist : 1;
+    }
+
+    if (sh != NULL) {
+        print_estimate(sh, sd, maxmem, compare);
+        return 0;
+    }
+
+    int tty = 0 <= tcgetpgrp(STDOUT_FILENO);
+    if (tty) {
+        printf("\n%-10s %8s %12s %12s %16s %10s %10s\n", "Algorithm",
+               "Memsize", "Hits", "Misses", "Total refs", "Hit rate",
+               "Miss rate");
+    }
+
+    // The first columns of the lines sim prints for several
+    // configurations; the write-backs, I/O cost and space figures that
+    // follow them there are left out
+    unsigned long hits = 0;
+    unsigned int m;
+    for (m = 1; m <= maxmem; m++) {
+        if (m <= sd->maxdist) {
+            hits += sd->hist[m];
+        }
+        unsigned long misses = sd->refs - hits;
+        printf(tty ? "%-10s %8u %12lu %12lu %16lu %10.4f %10.4f\n"
+                   : "%s %u %lu %lu %lu %.4f %.4f\n",
+               "lru", m, hits, misses, sd->refs,
+               (double) hits / sd->refs * 100,
+               (double) misses / sd->refs * 100);
+    }
+
+    return 0;
+}
@@ -0,0 +1,84 @@
+#ifndef PAGELIST_H
+#define PAGELIST_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+
+/* Doubly linked lists of page numbers for the replacement algorithms that
+ * keep pages in LRU order (arc, car, 2q, lirs). The links live in per-page
+ * prev/next arrays owned by the algorithm, so moving a page between lists
+ * is O(1) and needs no allocation. A page can be on several lists at once
+ * as long as each of them uses its own pair of link arrays.
+ *
+ * The head of a list is its least recently used end, the tail its most
+ * recently used end.
+ */
+
+#define PAGELIST_NIL UINT_MAX
+
+struct pagelist {
+    unsigned int head;
+    unsigned int tail;
+    unsigned int size;
+};
+
+static inline void pagelist_init(struct pagelist *l) {
+    l->head = l->tail = PAGELIST_NIL;
+    l->size = 0;
+}
+
+/* Append page at the MRU end of l.
+ */
+static inline void pagelist_push(struct pagelist *l, unsigned int *prev,
+                                 unsigned int *next, unsigned int page) {
+    prev[page] = l->tail;
+    next[page] = PAGELIST_NIL;
+    if (l->tail != PAGELIST_NIL) {
+        next[l->tail] = page;
+    } else {
+        l->head = page;
+    }
+    l->tail = page;
+    l->size++;
+}
+
+static inline void pagelist_remove(struct pagelist *l, unsigned int *prev,
+                                   unsigned int *next, unsigned int page) {
+    if (prev[page] != PAGELIST_NIL) {
+        next[prev[page]] = next[page];
+    } else {
+        l->head = next[page];
+    }
+    if (next[page] != PAGELIST_NIL) {
+        prev[next[page]] = prev[page];
+    } else {
+        l->tail = prev[page];
+    }
+    l->size--;
+}
+
+/* Remove and return the LRU page of l, which must not be empty.
+ */
+static inline unsigned int pagelist_pop(struct pagelist *l, unsigned int *prev,
+                                        unsigned int *next) {
+    unsigned int page = l->head;
+    pagelist_remove(l, prev, next, page);
+    return page;
+}
+
+/* Grow a per-page array of elements of the given size from old to n
+ * entries, filling the new entries with the byte fill.
+ */
+static inline void *page_array_grow(void *a, size_t size, unsigned int old,
+                                    unsigned int n, int fill) {
+    if ((a = realloc(a, n * size)) == NULL) {
+        perror("Malloc failed");
+        exit(1);
+    }
+    memset((char *) a + old * size, fill, (n - old) * size);
+    return a;
+}
+
+#endif
@@ -1,82 +1,273 @@
 #include <stdio.h>
 #include <assert.h>
 #include <stdlib.h>
-#include "avl.h"
-#include "pagetable.h"
+#include <string.h>
+#include "sim.h"
+#include "trace.h"
 
-struct avl_table *avl_tree = NULL;
-struct libavl_allocator avl_allocator_default;
-struct avl_traverser trav;
 
-extern int debug;
+static unsigned long page_hash(addr_t vpage, unsigned long mask) {
+	return ((vpage >> 12) * 0x9e3779b97f4a7c15UL >> 17) & mask;
+}
+
+static void *xcalloc(size_t nmemb, size_t size) {
+	void *p = calloc(nmemb, size);
+	if (p == NULL) {
+		perror("Malloc failed");
+		exit(1);
+	}
+	return p;
+}
+
+struct pageindex *pageindex_create(unsigned int shift) {
+	struct pageindex *pi = xcalloc(1, sizeof(struct pageindex));
+	pi->shift = shift;
+	pi->mask = (1 << 12) - 1;
+	pi->keys = xcalloc(pi->mask + 1, sizeof(addr_t));
+	pi->ids = xcalloc(pi->mask + 1, sizeof(unsigned int));
+	pi->capacity = 1 << 11;
+	pi->vaddrs = xcalloc(pi->capacity, sizeof(addr_t));
+	return pi;
+}
+
+/* Map [start, end) with huge pages, widened to huge page boundaries.
+ */
+void pageindex_add_huge(struct pageindex *pi, addr_t start, addr_t end) {
+	addr_t size = (addr_t) 1 << HUGE_PAGE_SHIFT;
 
+	pi->huge = realloc(pi->huge, (pi->nhuge + 1) * sizeof(struct hugeregion));
+	if (pi->huge == NULL) {
+		perror("Malloc failed");
+		exit(1);
+	}
+	pi->huge[pi->nhuge].start = start & ~(size - 1);
+	pi->huge[pi->nhuge].end = (end + size - 1) & ~(size - 1);
+	pi->nhuge++;
+}
 
-int page_cmp(const void *a, const void *b, void *p) {
-	struct page *aa = (struct page *) a;
-	struct page *bb = (struct page *) b;
+/* Double the hash table and re-insert every page.
+ */
+static void pageindex_grow(struct pageindex *pi) {
+	unsigned long mask = pi->mask * 2 + 1;
+	addr_t *keys = xcalloc(mask + 1, sizeof(addr_t));
+	unsigned int *ids = xcalloc(mask + 1, sizeof(unsigned int));
+	unsigned int i;
 
-	// Protect against NULL pointer (shouldn't happen)
-	if (!aa || !bb) {
-		return 0;
+	for (i = 0; i < pi->count; i++) {
+		unsigned long h = page_hash(pi->vaddrs[i], mask);
+		while (keys[h] != 0) {
+			h = (h + 1) & mask;
+		}
+		keys[h] = pi->vaddrs[i] + 1;
+		ids[h] = i;
 	}
+	free(pi->keys);
+	free(pi->ids);
+	pi->keys = keys;
+	pi->ids = ids;
+	pi->mask = mask;
+}
 
-	return aa->vaddr - bb->vaddr;
+/* Allocate the page table bookkeeping of pi for levels levels. Has to
+ * be called before any page is looked up.
+ */
+void pageindex_add_tables(struct pageindex *pi, unsigned int levels) {
+	pi->levels = levels;
+	pi->level = xcalloc(pi->capacity, sizeof(unsigned char));
+	pi->parent = xcalloc(pi->capacity, sizeof(unsigned int));
 }
 
-void page_print(void *d) {
-	struct page *dd = (struct page *) d;
+/* Key of the page table at level that translates vaddr.
+ */
+static addr_t table_key(struct pageindex *pi, addr_t vaddr,
+                        unsigned int level) {
+	addr_t n = (vaddr & ASID_ADDR_MASK) >> (pi->shift + PT_BITS * level);
+	addr_t asid = vaddr >> ASID_SHIFT & (MAX_PROCS - 1);
+
+	return PT_KEY | asid << PT_ASID_SHIFT | (addr_t) level << PT_LEVEL_SHIFT |
+	       n << PAGE_SHIFT;
+}
+
+/* Look up vpage, a page at level mapping vaddr; a new page table page
+ * brings in the tables above it as well.
+ */
+static unsigned int index_find(struct pageindex *pi, addr_t vpage,
+                               addr_t vaddr, unsigned int level) {
+	unsigned long h = page_hash(vpage, pi->mask);
+	addr_t key = vpage + 1;
+
+	while (pi->keys[h] != 0) {
+		if (pi->keys[h] == key) {
+			return pi->ids[h];
+		}
+		h = (h + 1) & pi->mask;
+	}
 
-	if (dd) {
-		printf(" %lx => %c %d \n", dd->vaddr, dd->type, dd->pframe);
+	// New page
+	if (pi->count == pi->capacity) {
+		pi->capacity *= 2;
+		pi->vaddrs = realloc(pi->vaddrs, pi->capacity * sizeof(addr_t));
+		if (pi->levels > 0) {
+			pi->level = realloc(pi->level, pi->capacity);
+			pi->parent = realloc(pi->parent,
+			                     pi->capacity * sizeof(unsigned int));
+		}
+		if (pi->vaddrs == NULL ||
+		    (pi->levels > 0 && (pi->level == NULL || pi->parent == NULL))) {
+			perror("Malloc failed");
+			exit(1);
+		}
 	}
+	pi->keys[h] = key;
+	pi->ids[h] = pi->count;
+	pi->vaddrs[pi->count] = vpage;
+	unsigned int id = pi->count;
+
+	// Keep the table at most half full
+	if (++pi->count * 2 > pi->mask) {
+		pageindex_grow(pi);
+	}
+
+	if (pi->levels > 0) {
+		unsigned int up = level + 1;
+		if (level == 0 && pageindex_shift(pi, vaddr) == HUGE_PAGE_SHIFT) {
+			up = 2;
+		}
+		unsigned int parent = PT_NONE;
+		if (level < pi->levels) {
+			parent = index_find(pi, table_key(pi, vaddr, up), vaddr, up);
+		}
+		pi->level[id] = (unsigned char) level;
+		pi->parent[id] = parent;
+	}
+	return id;
 }
 
+/* Return the page number of vpage, giving it the next free number if it
+ * has not been seen before.
+ */
+unsigned int pageindex_lookup(struct pageindex *pi, addr_t vpage) {
+	return index_find(pi, vpage, vpage, 0);
+}
 
-void init_pagetable() {
-	avl_tree = avl_create(page_cmp, NULL, NULL);
+/* Read the whole trace into r, numbering its pages with pi. With a
+ * region, the trace ends at the end marker, and the references up to the
+ * start marker are either kept to warm up the simulation (r->start marks
+ * where the statistics begin) or dropped if only is set. With collapse,
+ * runs of references to the same page are folded into their first one.
+ */
+void refs_load(struct refs *r, struct trace *t, struct pageindex *pi,
+               struct region *region, int only, int collapse) {
+	size_t capacity = trace_count(t) > 0 ? (size_t) trace_count(t) : 1 << 16;
+	struct trace_ref ref;
+
+	r->page = malloc(capacity * sizeof(unsigned int));
+	r->type = malloc(capacity);
+	r->repeat = collapse ? malloc(capacity * sizeof(unsigned int)) : NULL;
+	r->next = NULL;
+	r->count = 0;
+	r->start = 0;
+	while (trace_next(t, &ref)) {
+		if (region != NULL) {
+			int where = region_step(region, ref.vaddr);
+			if (where == REGION_AFTER) {
+				break;
+			}
+			if (only && where != REGION_INSIDE) {
+				continue;
+			}
+			if (where == REGION_START) {
+				r->start = r->count + 1;
+			}
+		}
+		unsigned int page = pageindex_page(pi, ref.vaddr);
+
+		// A run never crosses the start of the statistics
+		if (collapse && r->count > r->start &&
+		    same_run(r->page[r->count - 1], r->type[r->count - 1], page,
+		             ref.type) &&
+		    (r->repeat[r->count - 1] & REPEAT_MAX) < REPEAT_MAX) {
+			r->repeat[r->count - 1] =
+				repeat_add(r->repeat[r->count - 1], ref.type);
+			continue;
+		}
+
+		if ((size_t) r->count == capacity) {
+			capacity *= 2;
+			r->page = realloc(r->page, capacity * sizeof(unsigned int));
+			r->type = realloc(r->type, capacity);
+			if (collapse) {
+				r->repeat = realloc(r->repeat,
+				                    capacity * sizeof(unsigned int));
+			}
+		}
+		if (r->page == NULL || r->type == NULL ||
+		    (collapse && r->repeat == NULL)) {
+			perror("Malloc failed");
+			exit(1);
+		}
+		r->page[r->count] = page;
+		r->type[r->count] = ref.type;
+		if (collapse) {
+			r->repeat[r->count] = 0;
+		}
+		r->count++;
+	}
 }
 
-struct page *pagetable_insert(addr_t vaddr, char type) {
-	struct page *newpage = malloc(sizeof(struct page));
-	newpage->vaddr = vaddr;
-	newpage->type = type;
-	newpage->pframe = -1;
+/* Link every reference to the next reference to the same page, walking
+ * the trace backwards. This is all the lookahead that opt needs.
+ */
+void refs_link(struct refs *r, unsigned int npages) {
+	long *last = malloc(npages * sizeof(long));
+	long i;
 
-	void **p = avl_probe(avl_tree, newpage);
-	if (p == NULL) {
-		if (debug >= 0)
-			printf ("    Out of memory in insertion.\n");
-		avl_destroy (avl_tree, NULL);
+	r->next = malloc(r->count * sizeof(long));
+	if (last == NULL || (r->next == NULL && r->count > 0)) {
+		perror("Malloc failed");
 		exit(1);
 	}
-	
-	if (*p != newpage && debug) {
-		printf ("    Duplicate item in tree!\n");
+	for (i = 0; i < (long) npages; i++) {
+		last[i] = r->count;
 	}
-	if (*p != newpage) {
-		free(newpage);
+	for (i = r->count - 1; i >= 0; i--) {
+		r->next[i] = last[r->page[i]];
+		last[r->page[i]] = i;
 	}
-	return (struct page *) *p;
+	free(last);
 }
 
-struct page *find_page(addr_t vaddr) {
-	void *p = avl_find(avl_tree, (const void *)&vaddr);
-	assert(p != NULL);
-	return (struct page *) p;
+/* Make sure the page table of s has an entry for page.
+ */
+void pagetable_grow(struct sim *s, unsigned int page) {
+	unsigned int n = s->npages ? s->npages : 1 << 10;
+	while (n <= page) {
+		n *= 2;
+	}
 
+	s->pages = realloc(s->pages, n * sizeof(struct page));
+	if (s->pages == NULL) {
+		perror("Malloc failed");
+		exit(1);
+	}
+	unsigned int i;
+	for (i = s->npages; i < n; i++) {
+		s->pages[i].type = 0;
+		s->pages[i].pframe = -1;
+	}
+	s->npages = n;
 }
 
-void print_pagetable() {
-	if(avl_tree == NULL) {
+void print_pagetable(struct sim *s) {
+	unsigned int i;
+
+	if (s->index->count == 0) {
 		printf("Empty table\n");
 		return;
 	}
 
-	avl_t_init(&trav, avl_tree);
-
-	void *item;
-	while((item = avl_t_next(&trav)) != NULL) {
-		page_print(item);
+	for (i = 0; i < s->index->count && i < s->npages; i++) {
+		printf(" %lx => %c %d \n", s->index->vaddrs[i], s->pages[i].type,
+		       s->pages[i].pframe);
 	}
-
 }
@@ -1,50 +1,170 @@
+#ifndef PAGETABLE_H
+#define PAGETABLE_H
+
 #include <stdio.h>
 #include <stdlib.h>
-#include "avl.h"
 
-/* The avl tree is a simple way to get a fast look up table, and is
- * used to implement the page table.
+typedef unsigned long addr_t;
+
+// Default page size, and the size of huge pages (see pageindex_add_huge)
+#define PAGE_SHIFT 12
+#define HUGE_PAGE_SHIFT 21
+
+/* When several traces run as processes, each address carries the number
+ * of its process (its address space ID) above the 48 bits of a user
+ * address, so that their pages never share a page number.
  */
-extern struct avl_table *avl_tree;
-extern struct libavl_allocator avl_allocator_default;
+#define ASID_SHIFT 48
+#define ASID_ADDR_MASK (((addr_t) 1 << ASID_SHIFT) - 1)
+#define MAX_PROCS 16
 
-typedef unsigned long addr_t;
+/* The page index gives every distinct virtual page in a trace a small
+ * dense number, assigned in order of first reference. It is shared by
+ * all simulations of a trace, so each of them can keep its page table as
+ * a plain array indexed by page number.
+ *
+ * It also fixes the page size: 1 << shift bytes, except inside the huge
+ * page regions, which are mapped with 2 MiB pages.
+ */
+struct hugeregion {
+    addr_t start;          // Both aligned to the huge page size
+    addr_t end;
+};
 
-struct page {
-	addr_t vaddr; // key
-	char type;    // Instruction or data
-	int pframe;   // Page frame number. -1 if not in physical memory
+struct pageindex {
+    addr_t *keys;          // Hash table of vpage + 1 (0 marks an empty slot)
+    unsigned int *ids;     // Page number stored with each key
+    unsigned long mask;    // Hash table size - 1
+    addr_t *vaddrs;        // Virtual page of each page number
+    unsigned int count;    // Number of distinct pages seen so far
+    unsigned int capacity; // Allocated length of vaddrs
+
+    unsigned int shift;    // log2 of the page size
+    struct hugeregion *huge;
+    unsigned int nhuge;
+
+    unsigned int levels;   // Depth of the page tables, 0 if not modelled
+    unsigned char *level;  // Level of each page number, 0 for pages of
+                           // the trace (see pageindex_add_tables)
+    unsigned int *parent;  // Page table that maps each page number,
+                           // PT_NONE for the root
+};
+
+/* With page tables, the pages of a radix tree levels deep get page
+ * numbers of their own, so that the simulations can keep them in frames
+ * like any other page. Each table translates PT_BITS bits of the address;
+ * level 1 tables map the pages of the trace, except that huge pages are
+ * mapped directly by level 2, and the root is at level levels. Their keys
+ * are above PT_KEY, out of the way of the addresses in traces, with the
+ * level and the address space ID of the table below it.
+ */
+#define PT_BITS 9
+#define PT_MAX_LEVELS 5
+#define PT_KEY 0xf000000000000000UL
+#define PT_LEVEL_SHIFT 52
+#define PT_ASID_SHIFT 56
+#define PT_NONE ((unsigned int) -1)
+
+struct pageindex *pageindex_create(unsigned int shift);
+void pageindex_add_huge(struct pageindex *pi, addr_t start, addr_t end);
+void pageindex_add_tables(struct pageindex *pi, unsigned int levels);
+unsigned int pageindex_lookup(struct pageindex *pi, addr_t vpage);
+
+static inline int pageindex_is_table(const struct pageindex *pi,
+                                     unsigned int page) {
+    return pi->levels > 0 && pi->level[page] > 0;
+}
+
+/* Process that page (not a page table) belongs to.
+ */
+static inline unsigned int pageindex_asid(const struct pageindex *pi,
+                                          unsigned int page) {
+    return (unsigned int) (pi->vaddrs[page] >> ASID_SHIFT) & (MAX_PROCS - 1);
+}
+
+/* log2 of the size of the page holding vaddr.
+ */
+static inline unsigned int pageindex_shift(const struct pageindex *pi,
+                                           addr_t vaddr) {
+    unsigned int i;
+
+    // Huge page regions apply to every process
+    vaddr &= ASID_ADDR_MASK;
+    for (i = 0; i < pi->nhuge; i++) {
+        if (vaddr >= pi->huge[i].start && vaddr < pi->huge[i].end) {
+            return HUGE_PAGE_SHIFT;
+        }
+    }
+    return pi->shift;
+}
+
+/* Page number of the page holding vaddr.
+ */
+static inline unsigned int pageindex_page(struct pageindex *pi,
+                                          addr_t vaddr) {
+    unsigned int shift = pageindex_shift(pi, vaddr);
+    return pageindex_lookup(pi, vaddr & ~(((addr_t) 1 << shift) - 1));
+}
+
+/* A trace decoded into page numbers, for the simulations that need the
+ * whole reference string up front (opt).
+ *
+ * When collapsed, a run of references to the same page (on the same side
+ * of a split TLB: instructions or data) is kept as its first reference
+ * plus a repeat count, with REPEAT_DIRTY set if any of the repeats is a
+ * store or modify.
+ */
+#define REPEAT_DIRTY 0x80000000u
+#define REPEAT_MAX (REPEAT_DIRTY - 1)
+
+struct refs {
+    unsigned int *page;    // Page number of each reference
+    char *type;            // Access type of each reference
+    unsigned int *repeat;  // Collapsed repeats of each one, NULL if none
+    long *next;            // Position of the next reference to the same
+                           // page (count if there is none), see refs_link
+    long count;
+    long start;            // References before this one only warm up the
+                           // simulation (see struct region)
 };
 
+/* Whether a reference of the given type to page continues the run of
+ * the previous one, of type prev_type to prev_page.
+ */
+static inline int same_run(unsigned int prev_page, char prev_type,
+                           unsigned int page, char type) {
+    return page == prev_page && (type == 'I') == (prev_type == 'I');
+}
+
+static inline unsigned int repeat_add(unsigned int repeat, char type) {
+    return (repeat + 1) | (type == 'S' || type == 'M' ? REPEAT_DIRTY : 0);
+}
 
-int page_cmp(const void *a, const void *b, void *p); 
-void init_pagetable();
+struct trace;
+struct region;
+void refs_load(struct refs *r, struct trace *t, struct pageindex *pi,
+               struct region *region, int only, int collapse);
+void refs_link(struct refs *r, unsigned int npages);
 
-struct page *pagetable_insert(addr_t vaddr, char type);
-struct page *find_page(addr_t vaddr);
-void print_pagetable(void);
+struct page {
+	char type;    // Instruction or data
+	int pframe;   // Page frame number. -1 if not in physical memory
+};
 
-struct frame {
-	char in_use;   //
-	char type;     //Instruction (I) or Data (D)
-	addr_t vaddr;
-    unsigned long stamp;  // Time stamp of when this frame was last accessed
-    char ref;             // Reference bit used in clock
-    long next_use;        // Distance to next use; used by opt
+/* Physical memory, as one array per field of a frame, indexed by frame
+ * number. The policies that sweep memory only pull in the field they
+ * look at, and the byte-sized bits pack many frames to a cache line.
+ */
+struct coremap {
+    unsigned int *page;     // Page number of the resident page
+    unsigned long *stamp;   // Time stamp of when this frame was last accessed
+    unsigned char *ref;     // Reference bit used in clock
+    unsigned char *dirty;   // Written to since it was loaded
+    long *next_use;         // Position of the next use; used by opt
+    unsigned char *ahead;   // Read ahead and not used yet, NULL without
+                            // read-ahead
+    double *ready;          // When a page read ahead is in, NULL without
+                            // a device model
 };
 
-void rand_init();
-void lru_init();
-void clock_init();
-void fifo_init();
-void opt_init();
-
-int rand_evict();
-int lru_evict();
-int clock_evict();
-int fifo_evict();
-int opt_evict();
-
-// Functions called when memory is referenced
-void lru_reference(int frame);
-void opt_reference(int frame);
+#endif
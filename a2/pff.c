@@ -0,0 +1,93 @@
+#include <stdio.h>
+#include <assert.h>
+#include <unistd.h>
+#include <getopt.h>
+#include <stdlib.h>
+#include "sim.h"
+#include "pagelist.h"
+
+
+extern int debug;
+
+/* Page-fault-frequency policy (Chu and Opderbeck, 1972). The resident set
+ * only changes at faults. If the time since the previous fault is at most
+ * the threshold (-T), faults are frequent and the new page is simply
+ * added. Otherwise the program has settled down, and every page not
+ * referenced since the previous fault gives its frame back to the free
+ * pool. memsize caps the allocation; past it the LRU page is evicted.
+ *
+ * Resident pages are kept in LRU order, so the pages not used since the
+ * last fault are all at the head.
+ */
+
+struct pff {
+    struct pagelist lru;      // Resident pages, least recently used first
+    unsigned int *prev;       // List links, indexed by page number
+    unsigned int *next;
+    char *resident;
+    unsigned int npages;
+    long last_fault;          // Time of the previous fault
+    long misses;              // Miss count seen at the previous reference
+};
+
+int pff_evict(struct sim *s) {
+    struct pff *pff = s->alg_data;
+    unsigned int victim = pagelist_pop(&pff->lru, pff->prev, pff->next);
+
+    pff->resident[victim] = 0;
+    return s->pages[victim].pframe;
+}
+
+/* Move the page to the MRU end and, if this reference faulted after a
+ * long enough quiet spell, shrink the resident set.
+ */
+void pff_reference(struct sim *s, int frame) {
+    struct pff *pff = s->alg_data;
+    unsigned int page = s->page;
+
+    if (pff->npages < s->npages) {
+        pff->prev = page_array_grow(pff->prev, sizeof(unsigned int),
+                                    pff->npages, s->npages, 0);
+        pff->next = page_array_grow(pff->next, sizeof(unsigned int),
+                                    pff->npages, s->npages, 0);
+        pff->resident = page_array_grow(pff->resident, sizeof(char),
+                                        pff->npages, s->npages, 0);
+        pff->npages = s->npages;
+    }
+
+    if (pff->resident[page]) {
+        pagelist_remove(&pff->lru, pff->prev, pff->next, page);
+    }
+    pagelist_push(&pff->lru, pff->prev, pff->next, page);
+    pff->resident[page] = 1;
+    s->coremap.stamp[frame] = s->ref_count;
+
+    if (s->miss_count == pff->misses) {
+        return;
+    }
+    pff->misses = s->miss_count;
+
+    if (s->ref_count - pff->last_fault > s->params->window) {
+        while (1) {
+            unsigned int oldest = pff->lru.head;
+            int f = s->pages[oldest].pframe;
+            if ((long) s->coremap.stamp[f] >= pff->last_fault) {
+                break;
+            }
+            pagelist_pop(&pff->lru, pff->prev, pff->next);
+            pff->resident[oldest] = 0;
+            release_frame(s, f);
+        }
+    }
+    pff->last_fault = s->ref_count;
+}
+
+void pff_init(struct sim *s) {
+    struct pff *pff = calloc(1, sizeof(struct pff));
+    if (pff == NULL) {
+        perror("Malloc failed");
+        exit(1);
+    }
+    pagelist_init(&pff->lru);
+    s->alg_data = pff;
+}
@@ -3,28 +3,33 @@
 #include <unistd.h>
 #include <getopt.h>
 #include <stdlib.h>
-#include "pagetable.h"
-
-#define MAXLINE 256
-
-extern int memsize;
+#include "sim.h"
 
 extern int debug;
 
+struct rand {
+	// Private random number generator state, see nrand48(3)
+	unsigned short xsubi[3];
+};
 
-extern struct frame *coremap;
+int rand_evict(struct sim *s) {
+	struct rand *r = s->alg_data;
 
-int rand_evict() {
 	// choose a frame slot to evict a page from
-	int slot = (int)(random() % memsize);
+	int slot = (int)(nrand48(r->xsubi) % s->memsize);
 
-	// find the victime page in the pagetable and mark
-	// it as not in memory
-	struct page *victim = find_page(coremap[slot].vaddr);
-	victim->pframe = -1;
-	
 	return slot;
 }
 
-void rand_init() {
+void rand_init(struct sim *s) {
+	struct rand *r = malloc(sizeof(struct rand));
+	if (r == NULL) {
+		perror("Malloc failed");
+		exit(1);
+	}
+	// Same starting state as srand48(1)
+	r->xsubi[0] = 0x330e;
+	r->xsubi[1] = 1;
+	r->xsubi[2] = 0;
+	s->alg_data = r;
 }
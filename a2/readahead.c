@@ -0,0 +1,162 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "readahead.h"
+
+// Window of adaptive read-ahead when a stream is first seen
+#define READAHEAD_INITIAL 4
+
+/* Parse a -A argument of the form fixed|adaptive|stride[:pages] into c.
+ * Returns 0 if it is not valid.
+ */
+int readahead_parse(struct readahead_config *c, char *arg) {
+    char *colon = strchr(arg, ':');
+    size_t len = colon != NULL ? (size_t) (colon - arg) : strlen(arg);
+    char *end = "";
+
+    if (len == 5 && strncmp(arg, "fixed", len) == 0) {
+        c->policy = READAHEAD_FIXED;
+        c->window = 8;
+    } else if (len == 8 && strncmp(arg, "adaptive", len) == 0) {
+        c->policy = READAHEAD_ADAPTIVE;
+        c->window = 32;
+    } else if (len == 6 && strncmp(arg, "stride", len) == 0) {
+        c->policy = READAHEAD_STRIDE;
+        c->window = 4;
+    } else {
+        return 0;
+    }
+    if (colon != NULL) {
+        c->window = (int) strtol(colon + 1, &end, 10);
+    }
+    return *end == '\0' && c->window > 0;
+}
+
+/* Read-ahead as configured by c, with windows of at most limit pages.
+ */
+struct readahead *readahead_create(const struct readahead_config *c,
+                                   int limit) {
+    struct readahead *ra = calloc(1, sizeof(struct readahead));
+    if (ra == NULL) {
+        perror("Malloc failed");
+        exit(1);
+    }
+    ra->config = c;
+    ra->limit = c->window < limit ? c->window : limit;
+    return ra;
+}
+
+/* Read size pages of stream st ahead from its next page on, and make the
+ * first of them the marker.
+ */
+static int window(struct stream *st, int size, addr_t *start, long *step) {
+    st->size = size;
+    st->marker = st->next;
+    *start = st->next;
+    *step = st->stride;
+    st->next += size * st->stride;
+    return size;
+}
+
+/* Stream the fault on vpn continues, or NULL.
+ */
+static struct stream *continued(struct readahead *ra, addr_t vpn) {
+    int i;
+
+    for (i = 0; i < READAHEAD_STREAMS; i++) {
+        struct stream *st = &ra->streams[i];
+        if (st->stamp != 0 && st->stride != 0 &&
+            (vpn == st->last + st->stride || (st->size > 0 && vpn == st->next))) {
+            return st;
+        }
+    }
+    return NULL;
+}
+
+/* Stream not yet read ahead whose last fault is within reach of vpn, or
+ * the least recently used one made over for vpn.
+ */
+static struct stream *nearest(struct readahead *ra, addr_t vpn, long reach) {
+    struct stream *lru = &ra->streams[0];
+    int i;
+
+    for (i = 0; i < READAHEAD_STREAMS; i++) {
+        struct stream *st = &ra->streams[i];
+        long distance = (long) (vpn - st->last);
+        if (st->stamp != 0 && st->size == 0 && distance != 0 &&
+            labs(distance) <= reach) {
+            return st;
+        }
+        if (st->stamp < lru->stamp) {
+            lru = st;
+        }
+    }
+    memset(lru, 0, sizeof(struct stream));
+    lru->last = vpn;
+    return lru;
+}
+
+/* The program faulted on page vpn. Returns the number of pages to read
+ * ahead, from *start on, *step apart.
+ */
+int readahead_fault(struct readahead *ra, addr_t vpn, addr_t *start,
+                    long *step) {
+    const struct readahead_config *c = ra->config;
+    struct stream *st;
+    int n = 0;
+
+    if (c->policy == READAHEAD_FIXED) {
+        *start = vpn + 1;
+        *step = 1;
+        return ra->limit;
+    }
+    st = continued(ra, vpn);
+    if (st != NULL) {
+        int size = ra->limit;
+        if (c->policy == READAHEAD_ADAPTIVE) {
+            // Run on from the last window, or start one
+            size = st->size > 0 ? 2 * st->size : READAHEAD_INITIAL;
+            size = size < ra->limit ? size : ra->limit;
+        }
+        st->next = vpn + st->stride;
+        n = window(st, size, start, step);
+    } else if (c->policy == READAHEAD_STRIDE) {
+        // A second fault near the last one of a stream gives its stride
+        st = nearest(ra, vpn, READAHEAD_REACH);
+        st->stride = (long) (vpn - st->last);
+    } else {
+        st = nearest(ra, vpn, 0);
+        st->stride = 1;
+    }
+    st->last = vpn;
+    st->stamp = ++ra->clock;
+    return n;
+}
+
+/* The program used page vpn for the first time since it was read ahead,
+ * and room more pages fit in memory. Returns the pages to read ahead as
+ * readahead_fault does.
+ */
+int readahead_hit(struct readahead *ra, addr_t vpn, int room, addr_t *start,
+                  long *step) {
+    const struct readahead_config *c = ra->config;
+    int i;
+
+    if (c->policy == READAHEAD_FIXED || room <= 0) {
+        // Without room the stream goes on at its next fault
+        return 0;
+    }
+    for (i = 0; i < READAHEAD_STREAMS; i++) {
+        struct stream *st = &ra->streams[i];
+        if (st->stamp != 0 && st->size > 0 && vpn == st->marker) {
+            int size = st->size;
+            if (c->policy == READAHEAD_ADAPTIVE) {
+                size = 2 * size < ra->limit ? 2 * size : ra->limit;
+            }
+            size = size < room ? size : room;
+            st->stamp = ++ra->clock;
+            return window(st, size, start, step);
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,65 @@
+#ifndef READAHEAD_H
+#define READAHEAD_H
+
+#include "pagetable.h"
+
+/* Read-ahead: on a fault, the pages the program is likely to touch next
+ * are read in along with the one it asked for. The policies only pick
+ * the pages, as a window of virtual page numbers start, start + step,
+ * ... ; the simulation loads them.
+ *
+ * fixed reads the window pages that follow every faulting page.
+ * adaptive follows sequential streams, as Linux does: a fault next to
+ * the previous fault of a stream starts a window of 4 pages, and every
+ * time the program gets to the first page of a window, the next one is
+ * read at twice the size, up to window pages. A scan then keeps ahead
+ * of the program without faulting again.
+ * stride does the same with a fixed window along streams of any
+ * constant distance, once three faults in a row are evenly spaced.
+ *
+ * Up to READAHEAD_STREAMS streams are followed at once, such as the rows
+ * and columns of the matrices in matmul; a fault that fits none of them
+ * starts a new one in place of the least recently used.
+ *
+ * A window is never larger than memory less one frame, so that reading
+ * it in cannot evict the page that faulted or the window itself. The
+ * window that follows on from the pages read ahead only gets the frames
+ * they leave.
+ */
+
+#define READAHEAD_STREAMS 8
+#define READAHEAD_REACH 64  // Pages between faults of a stride stream
+
+enum { READAHEAD_FIXED, READAHEAD_ADAPTIVE, READAHEAD_STRIDE };
+
+struct readahead_config {
+    int window;             // Pages read ahead at most, 0 if there is no
+                            // read-ahead
+    int policy;
+};
+
+struct stream {
+    addr_t last;            // Page number of the last fault
+    long stride;            // Pages between its faults, 0 until known
+    int size;               // Pages in the last window, 0 if none
+    addr_t marker;          // Page whose first use reads the next window
+    addr_t next;            // Page the next window starts at
+    unsigned long stamp;    // When it was last used
+};
+
+struct readahead {
+    const struct readahead_config *config;
+    int limit;              // Pages a window may hold
+    struct stream streams[READAHEAD_STREAMS];
+    unsigned long clock;
+};
+
+int readahead_parse(struct readahead_config *c, char *arg);
+struct readahead *readahead_create(const struct readahead_config *c,
+                                   int limit);
+int readahead_fault(struct readahead *ra, addr_t vpn, addr_t *start,
+                    long *step);
+int readahead_hit(struct readahead *ra, addr_t vpn, int room, addr_t *start,
+                  long *step);
+
+#endif
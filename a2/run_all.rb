@@ -25,7 +25,32 @@ headings = [
     'Miss rate'
 ]
 
-%w(fifo lru clock opt).each do |alg|
+# Convert each trace to the binary format once, so that sim does not
+# have to parse the text trace again for every run
+BINARIES = TRACES.map do |trace|
+  bin = File.basename(trace) + '.bin'
+  system("./trace2bin -f #{trace} -o #{bin}") unless File.exist?(bin)
+  bin
+end
+
+ALGORITHMS = %w(fifo lru clock opt)
+MEMSIZES = [50, 100, 150, 200]
+
+# One run of sim per trace simulates every algorithm and memory size, and
+# prints a line "alg m hits misses refs hit_rate miss_rate ..."
+# for each; the tables keep the first five statistics
+results = Hash.new { |h, k| h[k] = [] }
+TRACES.each_with_index do |trace, i|
+  command = "./sim -f #{BINARIES[i]} -a #{ALGORITHMS.join(',')} -m #{MEMSIZES.join(',')}"
+  puts "Running command: #{command}\n"
+  `#{command}`.each_line do |line|
+    alg, m, *stats = line.split
+    next if alg.nil?
+    results[alg] << [trace, m.to_i] + stats.first(5)
+  end
+end
+
+ALGORITHMS.each do |alg|
   # Create a table per algorithm
   table = Terminal::Table.new
   table.title = alg
@@ -35,11 +60,7 @@ headings = [
   rows = []
 
   TRACES.each do |trace|
-    [50, 100, 150, 200].each do |m|
-      command = "./sim -f #{trace} -m #{m} -a #{alg}"
-      puts "Running command: #{command}\n"
-      rows << [trace, m] + `#{command}`.split
-    end
+    rows += results[alg].select { |row| row.first == trace }
 
     # Add separator between traces
     rows << :separator unless trace == TRACES.last
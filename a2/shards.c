@@ -0,0 +1,156 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "shards.h"
+
+static void *xrealloc(void *p, size_t size) {
+    if ((p = realloc(p, size)) == NULL) {
+        perror("Malloc failed");
+        exit(1);
+    }
+    return p;
+}
+
+struct shards *shards_create(double rate, unsigned int smax) {
+    struct shards *sh = calloc(1, sizeof(struct shards));
+    if (sh == NULL) {
+        perror("Malloc failed");
+        exit(1);
+    }
+    sh->threshold = (unsigned long) (rate * SHARDS_MODULUS);
+    if (sh->threshold == 0) {
+        sh->threshold = 1;
+    }
+    sh->smax = smax;
+    sh->index = pageindex_create(PAGE_SHIFT);
+    sh->sd = stackdist_create();
+    return sh;
+}
+
+double shards_rate(struct shards *sh) {
+    return (double) sh->threshold / SHARDS_MODULUS;
+}
+
+static void heap_push(struct shards *sh, unsigned long hash, unsigned int page) {
+    unsigned int i = sh->heapsize++;
+
+    if (sh->heapsize > sh->heapcap) {
+        sh->heapcap = sh->heapcap ? sh->heapcap * 2 : 1 << 10;
+        sh->heap = xrealloc(sh->heap, sh->heapcap * sizeof(struct shards_entry));
+    }
+    while (i > 0 && sh->heap[(i - 1) / 2].hash < hash) {
+        sh->heap[i] = sh->heap[(i - 1) / 2];
+        i = (i - 1) / 2;
+    }
+    sh->heap[i].hash = hash;
+    sh->heap[i].page = page;
+}
+
+static struct shards_entry heap_pop(struct shards *sh) {
+    struct shards_entry top = sh->heap[0];
+    struct shards_entry last = sh->heap[--sh->heapsize];
+    unsigned int i = 0;
+
+    while (2 * i + 1 < sh->heapsize) {
+        unsigned int c = 2 * i + 1;
+        if (c + 1 < sh->heapsize && sh->heap[c + 1].hash > sh->heap[c].hash) {
+            c++;
+        }
+        if (last.hash >= sh->heap[c].hash) {
+            break;
+        }
+        sh->heap[i] = sh->heap[c];
+        i = c;
+    }
+    sh->heap[i] = last;
+    return top;
+}
+
+/* Lower the threshold to the largest sampled hash, dropping every page
+ * with that hash, and reweigh what was counted at the old rate so that
+ * it matches the new one.
+ */
+static void lower_rate(struct shards *sh) {
+    unsigned long threshold = sh->heap[0].hash;
+    double scale = (double) threshold / sh->threshold;
+    unsigned long d;
+
+    while (sh->heapsize > 0 && sh->heap[0].hash == threshold) {
+        stackdist_forget(sh->sd, heap_pop(sh).page);
+    }
+    for (d = 0; d <= sh->maxdist && d < sh->histsize; d++) {
+        sh->hist[d] *= scale;
+    }
+    sh->cold *= scale;
+    sh->weight *= scale;
+    sh->threshold = threshold;
+}
+
+void shards_access(struct shards *sh, addr_t vaddr) {
+    addr_t vpage = vaddr & ~(((addr_t) 1 << PAGE_SHIFT) - 1);
+    unsigned long hash = shards_hash(vpage);
+
+    sh->refs++;
+    if (hash >= sh->threshold) {
+        return;
+    }
+    sh->samples++;
+
+    unsigned int count = sh->index->count;
+    unsigned int page = pageindex_lookup(sh->index, vpage);
+    unsigned int dist = stackdist_access(sh->sd, page);
+
+    sh->weight += 1;
+    if (dist == 0) {
+        sh->cold += 1;
+    } else {
+        // The page itself counts once; each other sampled page stands for 1/R
+        unsigned long scaled = 1 + (unsigned long)
+            ((dist - 1) / shards_rate(sh) + 0.5);
+        if (scaled >= sh->histsize) {
+            unsigned long n = sh->histsize ? sh->histsize : 1 << 10;
+            while (n <= scaled) {
+                n *= 2;
+            }
+            sh->hist = xrealloc(sh->hist, n * sizeof(double));
+            memset(sh->hist + sh->histsize, 0, (n - sh->histsize) * sizeof(double));
+            sh->histsize = n;
+        }
+        sh->hist[scaled] += 1;
+        if (scaled > sh->maxdist) {
+            sh->maxdist = scaled;
+        }
+    }
+
+    if (sh->smax > 0 && page == count) {
+        // first time this page is sampled
+        heap_push(sh, hash, page);
+        if (sh->heapsize > sh->smax) {
+            lower_rate(sh);
+        }
+    }
+}
+
+/* Estimated LRU miss ratio with memsize frames. At a fixed rate, the
+ * difference between the expected and the actual number of samples is
+ * counted as hits at distance 1 (the SHARDS_adj correction).
+ */
+double shards_miss_ratio(struct shards *sh, unsigned long memsize) {
+    double hits = 0;
+    double weight = sh->weight;
+    unsigned long d;
+
+    if (sh->smax == 0) {
+        double adjust = sh->refs * shards_rate(sh) - sh->samples;
+        hits += adjust;
+        weight += adjust;
+    }
+    for (d = 1; d <= memsize && d <= sh->maxdist; d++) {
+        hits += sh->hist[d];
+    }
+    if (weight <= 0) {
+        return 0;
+    }
+    double ratio = 1 - hits / weight;
+    return ratio < 0 ? 0 : ratio > 1 ? 1 : ratio;
+}
@@ -0,0 +1,58 @@
+#ifndef SHARDS_H
+#define SHARDS_H
+
+#include "pagetable.h"
+#include "stackdist.h"
+
+/* Spatially hashed sampling of pages (SHARDS, Waldspurger et al., FAST
+ * '15). A page is sampled when the hash of its virtual address is below
+ * a threshold T out of SHARDS_MODULUS, i.e. at rate R = T / modulus, so
+ * every reference to a sampled page is kept and none to the others. In
+ * the stack distances of the sampled stream, each other page stands for
+ * 1/R pages of the whole trace.
+ *
+ * With a bound smax on the number of sampled pages, the rate starts at
+ * the given value and is lowered whenever the sample outgrows the bound,
+ * by dropping the pages with the largest hashes.
+ */
+
+#define SHARDS_BITS 24
+#define SHARDS_MODULUS (1UL << SHARDS_BITS)
+
+static inline unsigned long shards_hash(addr_t vpage) {
+    unsigned long h = vpage * 0x9e3779b97f4a7c15UL;
+    h ^= h >> 29;
+    h *= 0xbf58476d1ce4e5b9UL;
+    return h >> (64 - SHARDS_BITS);
+}
+
+struct shards_entry {
+    unsigned long hash;
+    unsigned int page;
+};
+
+struct shards {
+    unsigned long threshold;    // Pages with hash below this are sampled
+    unsigned int smax;          // Bound on sampled pages, 0 for a fixed rate
+    struct shards_entry *heap;  // Sampled pages, largest hash on top
+    unsigned int heapsize;
+    unsigned int heapcap;
+
+    struct pageindex *index;    // Numbers the sampled pages
+    struct stackdist *sd;       // Stack distances among sampled pages
+
+    double *hist;               // hist[d]: weight of references at
+    unsigned long histsize;     // estimated distance d
+    unsigned long maxdist;
+    double cold;                // Weight of first references
+    double weight;              // Weight of all sampled references
+    unsigned long refs;         // References seen, sampled or not
+    unsigned long samples;      // References sampled
+};
+
+struct shards *shards_create(double rate, unsigned int smax);
+void shards_access(struct shards *sh, addr_t vaddr);
+double shards_rate(struct shards *sh);
+double shards_miss_ratio(struct shards *sh, unsigned long memsize);
+
+#endif
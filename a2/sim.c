@@ -4,207 +4,1512 @@
 #include <getopt.h>
 #include <stdlib.h>
 #include <string.h>
-#include "pagetable.h"
+#include <pthread.h>
+#include "sim.h"
+#include "trace.h"
+#include "pagelist.h"
 
-#define MAXLINE 256
+int debug = 0;
 
-int memsize = 0;
+struct functions algs[] = {
+    {"rand", rand_init, rand_evict, NULL, 0, 1},
+    {"lru", lru_init, lru_evict, lru_reference, 0, 1},
+    {"fifo", fifo_init, fifo_evict, NULL, 0, 1},
+    {"clock",clock_init, clock_evict, NULL, 0, 1},
+    {"opt", opt_init, opt_evict, opt_reference, 1, 1},
+    {"arc", arc_init, arc_evict, arc_reference},
+    {"car", car_init, car_evict, car_reference},
+    {"2q", twoq_init, twoq_evict, twoq_reference},
+    {"lirs", lirs_init, lirs_evict, lirs_reference},
+    {"eclock", eclock_init, eclock_evict, clock_reference, 0, 1},
+    {"wsclock", wsclock_init, wsclock_evict, wsclock_reference},
+    {"ws", ws_init, ws_evict, ws_reference},
+    {"pff", pff_init, pff_evict, pff_reference},
+    {"aging", aging_init, aging_evict, aging_reference}
+};
+int num_algs = 14;
 
-int debug = 0;
 
-int hit_count = 0;
-int miss_count = 0;
-int ref_count = 0;
+/* Set up s to simulate alg with memsize page frames. The page index is
+ * shared by every simulation of the trace; refs is only needed by
+ * algorithms that look ahead.
+ */
+void sim_init(struct sim *s, struct functions *alg, int memsize,
+              const struct sim_params *params, struct pageindex *index,
+              const struct refs *refs) {
+    memset(s, 0, sizeof(struct sim));
+    s->alg = alg;
+    s->memsize = memsize;
+    s->params = params;
+    s->index = index;
+    s->refs = refs;
+    s->asid = -1;
+
+    s->coremap.page = calloc((size_t) memsize, sizeof(unsigned int));
+    s->coremap.stamp = calloc((size_t) memsize, sizeof(unsigned long));
+    s->coremap.ref = calloc((size_t) memsize, sizeof(unsigned char));
+    s->coremap.dirty = calloc((size_t) memsize, sizeof(unsigned char));
+    s->coremap.next_use = calloc((size_t) memsize, sizeof(long));
+    s->free_frames = malloc((size_t) memsize * sizeof(int));
+    if (s->coremap.page == NULL || s->coremap.stamp == NULL ||
+        s->coremap.ref == NULL || s->coremap.dirty == NULL ||
+        s->coremap.next_use == NULL || s->free_frames == NULL) {
+        perror("Malloc failed");
+        exit(1);
+    }
+    pagetable_grow(s, index->count);
+
+    if (params->tlb.entries > 0) {
+        s->dtlb = tlb_create(&params->tlb);
+        s->itlb = params->tlb.split ? tlb_create(&params->tlb) : s->dtlb;
+    }
+    if (params->device.read_latency > 0) {
+        s->dev = device_create(&params->device);
+    }
+    if (params->readahead.window > 0) {
+        s->ra = readahead_create(&params->readahead, memsize - 1);
+        s->coremap.ahead = calloc((size_t) memsize, sizeof(unsigned char));
+        if (s->coremap.ahead == NULL) {
+            perror("Malloc failed");
+            exit(1);
+        }
+        if (s->dev != NULL) {
+            s->coremap.ready = calloc((size_t) memsize, sizeof(double));
+            if (s->coremap.ready == NULL) {
+                perror("Malloc failed");
+                exit(1);
+            }
+        }
+    }
+
+    if (params->nprocs > 1) {
+        s->procs = calloc((size_t) params->nprocs, sizeof(struct proc_counts));
+        if (s->procs == NULL) {
+            perror("Malloc failed");
+            exit(1);
+        }
+    }
+
+    if (params->series != NULL) {
+        s->series = calloc(1, sizeof(struct series));
+        if (s->series == NULL) {
+            perror("Malloc failed");
+            exit(1);
+        }
+    }
+
+    alg->init(s);
+}
 
-/* The algs array gives us a mapping between the name of an eviction
- * algorithm as given in a command line argument, and the function to
- * call to select the victim page.
+/* Release what sim_init allocated. The private state of the algorithm
+ * is freed as a single block.
  */
-struct functions {
-    char *name;
-    void (*init)(void);
-    int (*evict)();
-    void (*reference)(int frame);
-};
+void sim_free(struct sim *s) {
+    free(s->coremap.page);
+    free(s->coremap.stamp);
+    free(s->coremap.ref);
+    free(s->coremap.dirty);
+    free(s->coremap.next_use);
+    free(s->coremap.ahead);
+    free(s->coremap.ready);
+    free(s->free_frames);
+    free(s->pages);
+    if (s->dtlb != NULL) {
+        if (s->itlb != s->dtlb) {
+            tlb_free(s->itlb);
+        }
+        tlb_free(s->dtlb);
+    }
+    if (s->dev != NULL) {
+        device_free(s->dev);
+    }
+    free(s->ra);
+    free(s->procs);
+    if (s->series != NULL) {
+        free(s->series->seen);
+        free(s->series);
+    }
+    free(s->alg_data);
+}
 
-struct functions algs[] = {
-    {"rand", rand_init, rand_evict, NULL},
-    {"lru", lru_init, lru_evict, lru_reference},
-    {"fifo", fifo_init, fifo_evict, NULL},
-    {"clock",clock_init, clock_evict, NULL},
-    {"opt", opt_init, opt_evict, opt_reference}
-};
-int num_algs = 5;
+/* Size in bytes of page, which depends on whether it is a huge page.
+ */
+static addr_t page_bytes(const struct pageindex *pi, unsigned int page) {
+    if (pageindex_is_table(pi, page)) {
+        return (addr_t) 1 << pi->shift;
+    }
+    return (addr_t) 1 << pageindex_shift(pi, pi->vaddrs[page]);
+}
 
-int (*evict_fcn)() = NULL;
-void (*reference_fcn)(int frame) = NULL;
-void (*init_fcn)() = NULL;
+/* Virtual page number of page, as a TLB sees it. The page size goes in
+ * the bits above the address space ID, so that a huge page and a base
+ * page with the same number have different tags.
+ */
+static addr_t page_vpn(const struct pageindex *pi, unsigned int page) {
+    unsigned int shift = pageindex_shift(pi, pi->vaddrs[page]);
 
+    return (pi->vaddrs[page] >> shift) | (addr_t) shift << TLB_SHIFT_BIT;
+}
 
-/* The coremap holds information about physical memory.
- * The index into coremap is the physical page number stored
- * as paddr in the page table entry (struct page).
+/* Write the page in frame back to swap. The caller clears or drops its
+ * dirty bit.
  */
-struct frame *coremap = NULL;
+void write_back(struct sim *s, int frame) {
+    s->writeback_count++;
+    if (s->dev != NULL) {
+        device_write(s->dev, page_bytes(s->index, s->coremap.page[frame]));
+    }
+}
 
-/* The tracefile name is a global variable because the OPT
- * algorithm will need to read the file before you start
- * replaying the trace.
+/* Take the page in frame out of memory, writing it back if it is dirty.
  */
-char *tracefile = NULL;
+static void unmap_frame(struct sim *s, int frame) {
+    struct coremap *coremap = &s->coremap;
 
-int find_frame(struct page *p) {
-    int i;
-    int frame = -1;
-    for (i = 0; i < memsize; i++) {
-        if (!coremap[i].in_use) {
-            frame = i;
-            break;
+    // mark the victim page as not in memory
+    s->pages[coremap->page[frame]].pframe = -1;
+    s->evict_count++;
+
+    if (pageindex_is_table(s->index, coremap->page[frame])) {
+        s->pt_frames--;
+    } else if (s->dtlb != NULL) {
+        // drop its translation
+        addr_t vpn = page_vpn(s->index, coremap->page[frame]);
+        tlb_invalidate(s->dtlb, vpn);
+        if (s->itlb != s->dtlb) {
+            tlb_invalidate(s->itlb, vpn);
         }
     }
-    if (frame == -1) {
+    s->resident_bytes -= page_bytes(s->index, coremap->page[frame]);
+
+    if (coremap->ahead != NULL && coremap->ahead[frame]) {
+        s->wasted_count++;
+        coremap->ahead[frame] = 0;
+    }
+
+    // a modified victim has to be written back first
+    if (coremap->dirty[frame]) {
+        write_back(s, frame);
+    }
+}
+
+/* Give frame back to the free pool. Used by the algorithms that shrink
+ * the resident set (ws, pff); the others only ever replace pages.
+ */
+void release_frame(struct sim *s, int frame) {
+    unmap_frame(s, frame);
+    s->free_frames[s->num_free++] = frame;
+}
+
+int find_frame(struct sim *s, struct page *p) {
+    struct coremap *coremap = &s->coremap;
+    int frame;
+
+    if (s->num_free > 0) {
+        // Reuse a released frame
+        frame = s->free_frames[--s->num_free];
+    } else if (s->frames_used < s->memsize) {
+        // Frames are handed out in order, so the untouched ones are all
+        // at the end
+        frame = s->frames_used++;
+    } else {
         // Didn't find a free page
-        frame = evict_fcn();
+        frame = s->alg->evict(s);
+        assert(frame >= 0 && frame < s->memsize);
+        unmap_frame(s, frame);
+    }
+    s->resident_bytes += page_bytes(s->index, s->page);
+    if (s->resident_bytes > s->peak_resident_bytes) {
+        s->peak_resident_bytes = s->resident_bytes;
     }
-    coremap[frame].in_use = 1;
-    coremap[frame].vaddr = p->vaddr;
-    coremap[frame].type = p->type;
+    if (pageindex_is_table(s->index, s->page) &&
+        ++s->pt_frames > s->peak_pt_frames) {
+        s->peak_pt_frames = s->pt_frames;
+    }
+    coremap->page[frame] = s->page;
 
     // set the ref bit used by clock
-    coremap[frame].ref = 1;
+    coremap->ref[frame] = 1;
+    coremap->dirty[frame] = 0;
 
-    // initialize next use distance to -1
-    coremap[frame].next_use = -1;
+    // initialize next use position to -1
+    coremap->next_use[frame] = -1;
 
     return frame;
 }
 
-void access_mem(char type, addr_t vaddr) {
-    ref_count++;
-    // get the page
-    addr_t vpage = vaddr & ~0xfff;
+static void series_touch(struct sim *s, unsigned int page);
+
+/* Load the n pages from virtual page start on, step apart, that are not
+ * in memory, without waiting for them. They go in under the replacement
+ * algorithm as if referenced, and are marked until their first use.
+ * The window stops at the edge of the address space of the process of
+ * page.
+ */
+static void load_ahead(struct sim *s, unsigned int page, addr_t start,
+                       long step, int n) {
+    struct coremap *coremap = &s->coremap;
+    addr_t vaddr = s->index->vaddrs[page];
+    unsigned int shift = pageindex_shift(s->index, vaddr);
+    int k;
+
+    for (k = 0; k < n; k++) {
+        addr_t a = (start + k * step) << shift;
+        if (((a ^ vaddr) >> ASID_SHIFT) != 0) {
+            break;
+        }
+        unsigned int ahead = pageindex_page(s->index, a);
+        if (ahead >= s->npages) {
+            pagetable_grow(s, ahead);
+        }
+        struct page *p = &s->pages[ahead];
+        if (p->pframe != -1) {
+            continue;
+        }
+        s->page = ahead;
+        s->prefetch_count++;
+        p->pframe = find_frame(s, p);
+        coremap->ahead[p->pframe] = 1;
+        if (s->dev != NULL) {
+            coremap->ready[p->pframe] =
+                device_prefetch(s->dev, page_bytes(s->index, ahead));
+        }
+        if (s->alg->reference != NULL) {
+            s->alg->reference(s, p->pframe);
+        }
+    }
+}
+
+/* Read ahead on a reference to page: on a miss before it is given a
+ * frame, otherwise after it is referenced. The first use of a page read
+ * ahead waits for it to be in.
+ */
+static void read_ahead(struct sim *s, unsigned int page, int miss) {
+    struct coremap *coremap = &s->coremap;
+    int frame = s->pages[page].pframe;
+    addr_t vaddr = s->index->vaddrs[page];
+    addr_t vpn = vaddr >> pageindex_shift(s->index, vaddr);
+    addr_t start;
+    long step;
+    int n;
+
+    if (miss) {
+        n = readahead_fault(s->ra, vpn, &start, &step);
+    } else if (coremap->ahead[frame]) {
+        coremap->ahead[frame] = 0;
+        s->useful_count++;
+        if (s->dev != NULL) {
+            device_wait(s->dev, coremap->ready[frame]);
+        }
+        // The next window must not evict the pages still to be used
+        long pending = s->prefetch_count - s->useful_count - s->wasted_count;
+        n = readahead_hit(s->ra, vpn, (int) (s->memsize - 1 - pending),
+                          &start, &step);
+    } else {
+        return;
+    }
+    load_ahead(s, page, start, step, n);
+}
+
+/* Account for the references collapsed into the one to s->page just
+ * simulated (see struct refs). They are all hits, to the TLB as well,
+ * and only the dirty bit can change; the collapsible algorithms would do
+ * nothing on them, since the page is already their most recent one.
+ */
+void access_repeat(struct sim *s, char type, unsigned int repeat) {
+    long n = repeat & REPEAT_MAX;
+
+    s->ref_count += n;
+    s->hit_count += n;
+    if (repeat & REPEAT_DIRTY) {
+        s->coremap.dirty[s->pages[s->page].pframe] = 1;
+    }
+    if (s->dtlb != NULL) {
+        (type == 'I' ? s->itlb : s->dtlb)->hits += n;
+    }
+    s->space_time += n * (s->frames_used - s->num_free);
+    s->pt_space_time += n * s->pt_frames;
+    if (s->dev != NULL) {
+        device_run(s->dev, n);
+    }
+    if (s->procs != NULL) {
+        s->procs[pageindex_asid(s->index, s->page)].refs += n;
+    }
+}
+
+/* Reference the page table pages on the walk to page, from the root
+ * down. They fault in and take frames like any other page, but are
+ * counted apart from the references of the trace.
+ */
+static void walk_tables(struct sim *s, unsigned int page) {
+    const struct pageindex *pi = s->index;
+    unsigned int path[PT_MAX_LEVELS];
+    int n = 0;
+    unsigned int table;
+
+    for (table = pi->parent[page]; table != PT_NONE; table = pi->parent[table]) {
+        path[n++] = table;
+    }
+    while (n > 0) {
+        table = path[--n];
+        if (table >= s->npages) {
+            pagetable_grow(s, table);
+        }
+        struct page *p = &s->pages[table];
+        p->type = 'L';
+        s->page = table;
+        s->walk_count++;
+        if (p->pframe == -1) {
+            s->pt_miss_count++;
+            p->pframe = find_frame(s, p);
+            if (s->dev != NULL) {
+                device_read(s->dev, page_bytes(pi, table));
+            }
+        }
+        if (s->alg->reference != NULL) {
+            s->alg->reference(s, p->pframe);
+        }
+    }
+}
+
+void access_mem(struct sim *s, unsigned int page, char type) {
+    s->ref_count++;
+    if (s->dev != NULL) {
+        device_run(s->dev, 1);
+    }
+
+    // Translations of evicted pages are dropped, so a TLB hit is always
+    // to a page in memory
+    int tlb_hit = 0;
+    if (s->dtlb != NULL) {
+        tlb_hit = tlb_lookup(type == 'I' ? s->itlb : s->dtlb,
+                             page_vpn(s->index, page));
+    }
+    // Any other reference walks the page tables, if they are modelled
+    if (s->index->levels > 0 && !tlb_hit) {
+        walk_tables(s, page);
+    }
+
     // make sure the page is in the page table
-    struct page *p = pagetable_insert(vpage, type);
-    assert(p != NULL);
+    if (page >= s->npages) {
+        pagetable_grow(s, page);
+    }
+    struct page *p = &s->pages[page];
+    if (p->type == 0) {
+        p->type = type;
+    }
+    s->page = page;
 
     // If p->pframe is -1 then the page is not in physical memory
-    if(p->pframe == -1) {
-        miss_count++;
-        p->pframe = find_frame(p);
+    int miss = p->pframe == -1;
+    if (miss) {
+        s->miss_count++;
+        if (s->dev != NULL) {
+            device_read(s->dev, page_bytes(s->index, page));
+        }
+        // The pages read ahead go in first, so that they rank below the
+        // one that faulted and cannot evict it
+        if (s->ra != NULL) {
+            read_ahead(s, page, 1);
+            s->page = page;
+            p = &s->pages[page];
+        }
+        p->pframe = find_frame(s, p);
     } else {
-        hit_count++;
+        s->hit_count++;
+    }
+    if (s->procs != NULL) {
+        struct proc_counts *pc = &s->procs[pageindex_asid(s->index, page)];
+        pc->refs++;
+        pc->misses += miss;
+    }
+
+    // Stores (S) and modifies (M) leave the page dirty
+    if (type == 'S' || type == 'M') {
+        s->coremap.dirty[p->pframe] = 1;
     }
 
     // Call the reference function if defined
-    if (reference_fcn != NULL) {
-        reference_fcn(p->pframe);
+    if (s->alg->reference != NULL) {
+        s->alg->reference(s, p->pframe);
+    }
+
+    if (s->ra != NULL && !miss) {
+        read_ahead(s, page, 0);
+        s->page = page;
+    }
+
+    // Space-time product, in frames held per reference
+    s->space_time += s->frames_used - s->num_free;
+    s->pt_space_time += s->pt_frames;
+
+    if (s->series != NULL) {
+        series_touch(s, page);
+    }
+}
+
+/* Count page as touched in the current interval, and close the interval
+ * once it is full.
+ */
+static void series_touch(struct sim *s, unsigned int page) {
+    struct series *se = s->series;
+    unsigned int interval =
+        (unsigned int) ((s->ref_count - 1) / s->params->interval) + 1;
+
+    if (page >= se->nseen) {
+        se->seen = page_array_grow(se->seen, sizeof(unsigned int), se->nseen,
+                                   s->npages, 0);
+        se->nseen = s->npages;
+    }
+    if (se->seen[page] != interval) {
+        se->seen[page] = interval;
+        se->distinct++;
+    }
+    if (s->ref_count % s->params->interval == 0) {
+        series_row(s);
+    }
+}
+
+/* Write the row of the interval ending at the current reference and
+ * start the next one. Rows of simulations running on different threads
+ * may interleave, but each is written whole.
+ */
+void series_row(struct sim *s) {
+    struct series *se = s->series;
+
+    fprintf(s->params->series, "%s,%d,%ld,%ld,%ld,%ld,%ld,%d\n",
+            s->alg->name, s->memsize, s->ref_count, s->hit_count - se->hits,
+            s->miss_count - se->misses, s->evict_count - se->evictions,
+            se->distinct, s->frames_used - s->num_free);
+    se->hits = s->hit_count;
+    se->misses = s->miss_count;
+    se->evictions = s->evict_count;
+    se->distinct = 0;
+}
+
+/* Remember the counters at the start of the marker region, so that the
+ * references before it only warm up the simulation.
+ */
+void sim_mark(struct sim *s) {
+    s->mark.hits = s->hit_count;
+    s->mark.misses = s->miss_count;
+    s->mark.refs = s->ref_count;
+    s->mark.writebacks = s->writeback_count;
+    s->mark.evictions = s->evict_count;
+    s->mark.space_time = s->space_time;
+    s->mark.walks = s->walk_count;
+    s->mark.pt_misses = s->pt_miss_count;
+    s->mark.pt_space_time = s->pt_space_time;
+    s->mark.prefetches = s->prefetch_count;
+    s->mark.useful = s->useful_count;
+    s->mark.wasted = s->wasted_count;
+    if (s->dev != NULL) {
+        device_mark(s->dev);
+    }
+    if (s->dtlb != NULL) {
+        s->mark.tlb_hits[0] = s->dtlb->hits;
+        s->mark.tlb_misses[0] = s->dtlb->misses;
+        s->mark.tlb_hits[1] = s->itlb->hits;
+        s->mark.tlb_misses[1] = s->itlb->misses;
+    }
+}
+
+/* Leave only the counts since sim_mark, once the simulation is over (the
+ * algorithms use ref_count as their clock).
+ */
+void sim_unmark(struct sim *s) {
+    s->hit_count -= s->mark.hits;
+    s->miss_count -= s->mark.misses;
+    s->ref_count -= s->mark.refs;
+    s->writeback_count -= s->mark.writebacks;
+    s->evict_count -= s->mark.evictions;
+    s->space_time -= s->mark.space_time;
+    s->walk_count -= s->mark.walks;
+    s->pt_miss_count -= s->mark.pt_misses;
+    s->pt_space_time -= s->mark.pt_space_time;
+    s->prefetch_count -= s->mark.prefetches;
+    s->useful_count -= s->mark.useful;
+    s->wasted_count -= s->mark.wasted;
+    if (s->dev != NULL) {
+        device_unmark(s->dev);
+    }
+    if (s->dtlb != NULL) {
+        s->dtlb->hits -= s->mark.tlb_hits[0];
+        s->dtlb->misses -= s->mark.tlb_misses[0];
+        if (s->itlb != s->dtlb) {
+            s->itlb->hits -= s->mark.tlb_hits[1];
+            s->itlb->misses -= s->mark.tlb_misses[1];
+        }
+    }
+}
+
+/* Frames held on average per reference by both s and part, which hold
+ * theirs side by side, scaled back to the references of both.
+ */
+static long merge_space_time(const struct sim *s, long st,
+                             const struct sim *part, long part_st) {
+    double avg = (s->ref_count > 0 ? (double) st / s->ref_count : 0) +
+                 (part->ref_count > 0 ? (double) part_st / part->ref_count : 0);
+    return (long) (avg * (s->ref_count + part->ref_count) + 0.5);
+}
+
+/* Add the results of part, a local partition of s, to those of s.
+ * Peaks are summed, which bounds the peak of the whole.
+ */
+void sim_merge(struct sim *s, const struct sim *part) {
+    int i;
+
+    s->space_time = merge_space_time(s, s->space_time, part, part->space_time);
+    s->pt_space_time = merge_space_time(s, s->pt_space_time, part,
+                                        part->pt_space_time);
+    s->memsize += part->memsize;
+    s->hit_count += part->hit_count;
+    s->miss_count += part->miss_count;
+    s->ref_count += part->ref_count;
+    s->writeback_count += part->writeback_count;
+    s->evict_count += part->evict_count;
+    s->peak_resident_bytes += part->peak_resident_bytes;
+    s->walk_count += part->walk_count;
+    s->pt_miss_count += part->pt_miss_count;
+    s->peak_pt_frames += part->peak_pt_frames;
+    s->prefetch_count += part->prefetch_count;
+    s->useful_count += part->useful_count;
+    s->wasted_count += part->wasted_count;
+    if (s->dtlb != NULL) {
+        s->dtlb->hits += part->dtlb->hits;
+        s->dtlb->misses += part->dtlb->misses;
+        if (s->itlb != s->dtlb) {
+            s->itlb->hits += part->itlb->hits;
+            s->itlb->misses += part->itlb->misses;
+        }
+    }
+    // The processes take turns on one processor
+    if (s->dev != NULL) {
+        s->dev->now += part->dev->now;
+        s->dev->busy += part->dev->busy;
+        s->dev->stall += part->dev->stall;
+    }
+    for (i = 0; i < s->params->nprocs; i++) {
+        s->procs[i].refs += part->procs[i].refs;
+        s->procs[i].misses += part->procs[i].misses;
+    }
+}
+
+/* Whether s takes the references to page, i.e. it is not the partition
+ * of another process.
+ */
+static inline int sim_takes(const struct sim *s, unsigned int page) {
+    return s->asid < 0 || (unsigned int) s->asid == pageindex_asid(s->index, page);
+}
+
+/* Simulate a reference and its collapsed repeats on all nsims
+ * simulations.
+ */
+static void replay_run(struct sim *sims, int nsims, unsigned int page,
+                       char type, unsigned int repeat) {
+    int i;
+
+    for (i = 0; i < nsims; i++) {
+        if (!sim_takes(&sims[i], page)) {
+            continue;
+        }
+        access_mem(&sims[i], page, type);
+        if (repeat != 0) {
+            access_repeat(&sims[i], type, repeat);
+        }
     }
 }
 
-void replay_trace(FILE *infp) {
-    char buf[MAXLINE];
-    addr_t vaddr = 0;
-    int length = 0;
-    char type;
+/* Feed every reference in the trace to all nsims simulations in a single
+ * pass. Each page is looked up in the shared page index only once.
+ * With a region, the trace ends at the end marker, and the references
+ * before the start marker either only warm up the simulations or are
+ * dropped if only is set. With collapse, runs of references to the same
+ * page are simulated as one (see struct refs).
+ */
+void replay_trace(struct trace *t, struct pageindex *index,
+                  struct sim *sims, int nsims, struct region *region,
+                  int only, int collapse) {
+    struct trace_ref ref;
+    unsigned int run_page = 0;
+    char run_type = 0;          // 0 if there is no pending run
+    unsigned int repeat = 0;
+    int i;
+
+    while (trace_next(t, &ref)) {
+        if (debug)  {
+            printf("%c %lx, %u\n", ref.type, ref.vaddr, ref.length);
+        }
+        int where = region != NULL ? region_step(region, ref.vaddr)
+                                   : REGION_INSIDE;
+        if (where == REGION_AFTER) {
+            break;
+        }
+        if (only && where != REGION_INSIDE) {
+            continue;
+        }
+        unsigned int page = pageindex_page(index, ref.vaddr);
 
-    while (fgets(buf, MAXLINE, infp) != NULL) {
-        if (buf[0] != '=') {
-            sscanf(buf, " %c %lx,%u", &type, &vaddr, &length);
-            if (debug)  {
-                printf("%c %lx, %u\n", type, vaddr, length);
+        if (collapse && run_type != 0 &&
+            same_run(run_page, run_type, page, ref.type) &&
+            (repeat & REPEAT_MAX) < REPEAT_MAX) {
+            repeat = repeat_add(repeat, ref.type);
+            continue;
+        }
+        if (run_type != 0) {
+            replay_run(sims, nsims, run_page, run_type, repeat);
+        }
+        run_page = page;
+        run_type = ref.type;
+        repeat = 0;
+
+        // A run never crosses the start of the statistics
+        if (where == REGION_START) {
+            replay_run(sims, nsims, run_page, run_type, 0);
+            run_type = 0;
+            for (i = 0; i < nsims; i++) {
+                sim_mark(&sims[i]);
             }
-            access_mem(type, vaddr);
-        } else {
+        }
+    }
+    if (run_type != 0) {
+        replay_run(sims, nsims, run_page, run_type, repeat);
+    }
+}
+
+/* Run one simulation over an already decoded trace.
+ */
+void replay_refs(struct sim *s, const struct refs *refs) {
+    long i;
+
+    for (i = 0; i < refs->count; i++) {
+        if (i == refs->start) {
+            sim_mark(s);
+        }
+        if (!sim_takes(s, refs->page[i])) {
             continue;
         }
+        s->position = i;
+        access_mem(s, refs->page[i], refs->type[i]);
+        if (refs->repeat != NULL && refs->repeat[i] != 0) {
+            access_repeat(s, refs->type[i], refs->repeat[i]);
+        }
     }
 }
 
+/* Simulations waiting for a worker thread. Every simulation only reads
+ * the shared decoded trace and page index, so they can run side by side.
+ */
+struct pool {
+    struct sim *sims;
+    int nsims;
+    int next;                // Next simulation to hand out
+    pthread_mutex_t lock;
+    const struct refs *refs;
+};
+
+void *pool_worker(void *arg) {
+    struct pool *pool = arg;
+    int i;
+
+    while (1) {
+        pthread_mutex_lock(&pool->lock);
+        i = pool->next++;
+        pthread_mutex_unlock(&pool->lock);
+        if (i >= pool->nsims) {
+            break;
+        }
+        replay_refs(&pool->sims[i], pool->refs);
+    }
+    return NULL;
+}
+
+/* Run all nsims simulations over the decoded trace on nthreads threads.
+ */
+void replay_parallel(struct sim *sims, int nsims, const struct refs *refs,
+                     int nthreads) {
+    struct pool pool = {sims, nsims, 0, PTHREAD_MUTEX_INITIALIZER, refs};
+    pthread_t *threads = malloc(nthreads * sizeof(pthread_t));
+    int i;
+
+    if (threads == NULL) {
+        perror("Malloc failed");
+        exit(1);
+    }
+    // The main thread is one of the workers
+    for (i = 1; i < nthreads; i++) {
+        if (pthread_create(&threads[i], NULL, pool_worker, &pool) != 0) {
+            perror("pthread_create");
+            exit(1);
+        }
+    }
+    pool_worker(&pool);
+    for (i = 1; i < nthreads; i++) {
+        pthread_join(threads[i], NULL);
+    }
+    free(threads);
+}
+
+/* Estimated I/O cost of the run: a read for every miss, including those
+ * on page tables, and for every page read ahead, and a write for every
+ * dirty victim.
+ */
+double io_cost(struct sim *s) {
+    return (s->miss_count + s->pt_miss_count + s->prefetch_count) *
+           s->params->read_cost +
+           s->writeback_count * s->params->write_cost;
+}
+
+/* Cycles spent on address translation: every lookup costs a TLB access,
+ * and every miss a page walk.
+ */
+long tlb_cycles(struct sim *s) {
+    long cycles = s->dtlb->hits * TLB_HIT_CYCLES +
+                  s->dtlb->misses * (TLB_HIT_CYCLES + TLB_WALK_CYCLES);
+    if (s->itlb != s->dtlb) {
+        cycles += s->itlb->hits * TLB_HIT_CYCLES +
+                  s->itlb->misses * (TLB_HIT_CYCLES + TLB_WALK_CYCLES);
+    }
+    return cycles;
+}
+
+static double stat_hits(struct sim *s) { return s->hit_count; }
+static double stat_misses(struct sim *s) { return s->miss_count; }
+static double stat_refs(struct sim *s) { return s->ref_count; }
+static double stat_writebacks(struct sim *s) { return s->writeback_count; }
+
+static double stat_hit_rate(struct sim *s) {
+    return (double) s->hit_count / s->ref_count * 100;
+}
+
+static double stat_miss_rate(struct sim *s) {
+    return (double) s->miss_count / s->ref_count * 100;
+}
+
+static double stat_itlb_rate(struct sim *s) {
+    return (double) s->itlb->hits / (s->itlb->hits + s->itlb->misses) * 100;
+}
+
+static double stat_dtlb_rate(struct sim *s) {
+    return (double) s->dtlb->hits / (s->dtlb->hits + s->dtlb->misses) * 100;
+}
+
+static double stat_tlb_rate(struct sim *s) {
+    long hits = s->dtlb->hits + (s->itlb != s->dtlb ? s->itlb->hits : 0);
+    return (double) hits / s->ref_count * 100;
+}
+
+static double stat_tlb_cycles(struct sim *s) { return tlb_cycles(s); }
+
+static double stat_avg_resident(struct sim *s) {
+    return (double) s->space_time / s->ref_count;
+}
+
+static double stat_space_time(struct sim *s) { return s->space_time; }
+
+static double stat_peak_resident(struct sim *s) {
+    return s->peak_resident_bytes >> 10;
+}
+
+static double stat_walks(struct sim *s) { return s->walk_count; }
+static double stat_pt_misses(struct sim *s) { return s->pt_miss_count; }
+
+static double stat_avg_pt_frames(struct sim *s) {
+    return (double) s->pt_space_time / s->ref_count;
+}
+
+static double stat_peak_pt_frames(struct sim *s) { return s->peak_pt_frames; }
+
+/* Jain's fairness index of the fault rates of the processes: 1 when they
+ * are all equal, down to 1/n when one process takes all the faults.
+ */
+static double stat_fairness(struct sim *s) {
+    double sum = 0;
+    double squares = 0;
+    int n = 0;
+    int i;
+
+    for (i = 0; i < s->params->nprocs; i++) {
+        if (s->procs[i].refs > 0) {
+            double rate = (double) s->procs[i].misses / s->procs[i].refs;
+            sum += rate;
+            squares += rate * rate;
+            n++;
+        }
+    }
+    return squares > 0 ? sum * sum / (n * squares) : 1;
+}
+
+static double stat_run_time(struct sim *s) { return s->dev->now / 1e6; }
+
+static double stat_access_time(struct sim *s) {
+    return s->dev->now / s->ref_count;
+}
+
+static double stat_stall(struct sim *s) { return s->dev->stall / 1e6; }
+
+/* Share of the device's capacity in use over the run. Write-backs still
+ * in progress at the end can push it past 100.
+ */
+static double stat_device_busy(struct sim *s) {
+    double busy = s->dev->busy / (s->dev->now * s->dev->config->depth) * 100;
+    return busy < 100 ? busy : 100;
+}
+
+static double stat_prefetches(struct sim *s) { return s->prefetch_count; }
+static double stat_useful(struct sim *s) { return s->useful_count; }
+static double stat_wasted(struct sim *s) { return s->wasted_count; }
+
+/* Share of the pages read ahead that were used before being evicted.
+ */
+static double stat_accuracy(struct sim *s) {
+    return s->prefetch_count > 0
+           ? (double) s->useful_count / s->prefetch_count * 100 : 0;
+}
+
+static int has_tlb(struct sim *s) { return s->dtlb != NULL; }
+static int has_device(struct sim *s) { return s->dev != NULL; }
+static int has_procs(struct sim *s) { return s->procs != NULL; }
+static int has_readahead(struct sim *s) { return s->ra != NULL; }
+static int has_tables(struct sim *s) { return s->index->levels > 0; }
+static int has_split_tlb(struct sim *s) { return s->itlb != s->dtlb; }
+
+static int has_page_sizes(struct sim *s) {
+    return s->index->shift != PAGE_SHIFT || s->index->nhuge > 0;
+}
+
+/* The results printed for each simulation, in order. Optional ones are
+ * only printed when shown() says they apply to the run.
+ */
+struct stat {
+    const char *label;              // Label when there is one simulation
+    const char *heading;            // Column heading of the table
+    int width;                      // Column width of the table
+    int decimals;
+    double (*value)(struct sim *s);
+    int (*shown)(struct sim *s);    // NULL if always printed
+};
+
+static struct stat stats[] = {
+    {"Hit count:", "Hits", 12, 0, stat_hits, NULL},
+    {"Miss count:", "Misses", 12, 0, stat_misses, NULL},
+    {"Total references:", "Total refs", 16, 0, stat_refs, NULL},
+    {"Hit rate:", "Hit rate", 10, 4, stat_hit_rate, NULL},
+    {"Miss rate:", "Miss rate", 10, 4, stat_miss_rate, NULL},
+    {"Write-backs:", "Write-backs", 12, 0, stat_writebacks, NULL},
+    {"I/O cost:", "I/O cost", 14, 1, io_cost, NULL},
+    {"Avg resident:", "Avg resident", 12, 2, stat_avg_resident, NULL},
+    {"Space-time:", "Space-time", 16, 0, stat_space_time, NULL},
+    {"ITLB hit rate:", "ITLB hits", 10, 4, stat_itlb_rate, has_split_tlb},
+    {"DTLB hit rate:", "DTLB hits", 10, 4, stat_dtlb_rate, has_split_tlb},
+    {"TLB hit rate:", "TLB hits", 10, 4, stat_tlb_rate, has_tlb},
+    {"TLB cycles:", "TLB cycles", 14, 0, stat_tlb_cycles, has_tlb},
+    {"Peak resident KiB:", "Peak KiB", 12, 0, stat_peak_resident, has_page_sizes},
+    {"Walk references:", "Walk refs", 12, 0, stat_walks, has_tables},
+    {"Page table faults:", "PT faults", 12, 0, stat_pt_misses, has_tables},
+    {"Avg table frames:", "Avg PT", 10, 2, stat_avg_pt_frames, has_tables},
+    {"Peak table frames:", "Peak PT", 8, 0, stat_peak_pt_frames, has_tables},
+    {"Fairness:", "Fairness", 10, 4, stat_fairness, has_procs},
+    {"Run time (ms):", "Run ms", 12, 3, stat_run_time, has_device},
+    {"Access time (ns):", "Access ns", 10, 2, stat_access_time, has_device},
+    {"Fault stall (ms):", "Stall ms", 12, 3, stat_stall, has_device},
+    {"Device busy (%):", "Busy %", 8, 2, stat_device_busy, has_device},
+    {"Read ahead:", "Read ahead", 12, 0, stat_prefetches, has_readahead},
+    {"Used ahead:", "Used", 12, 0, stat_useful, has_readahead},
+    {"Wasted ahead:", "Wasted", 12, 0, stat_wasted, has_readahead},
+    {"Ahead used (%):", "Used %", 8, 2, stat_accuracy, has_readahead},
+};
+static const int num_stats = sizeof(stats) / sizeof(stats[0]);
+
+static int stat_shown(struct stat *st, struct sim *s) {
+    return st->shown == NULL || st->shown(s);
+}
+
+void print_results(struct sim *sims, int nsims) {
+    int tty = 0 <= tcgetpgrp(STDOUT_FILENO);
+    int i, k;
+
+    printf("\n");
+    if (nsims == 1) {
+        // One value per line, labelled on a terminal
+        struct sim *s = &sims[0];
+        for (k = 0; k < num_stats; k++) {
+            if (stat_shown(&stats[k], s)) {
+                if (tty) {
+                    printf("%-18s %.*f\n", stats[k].label, stats[k].decimals,
+                           stats[k].value(s));
+                } else {
+                    printf("%.*f\n", stats[k].decimals, stats[k].value(s));
+                }
+            }
+        }
+        return;
+    }
+
+    /* A table on a terminal, otherwise one line per configuration:
+     * "alg memsize hits misses refs hit_rate miss_rate ..."
+     */
+    if (tty) {
+        printf("%-10s %8s", "Algorithm", "Memsize");
+        for (k = 0; k < num_stats; k++) {
+            if (stat_shown(&stats[k], &sims[0])) {
+                printf(" %*s", stats[k].width, stats[k].heading);
+            }
+        }
+        printf("\n");
+    }
+    for (i = 0; i < nsims; i++) {
+        struct sim *s = &sims[i];
+        printf(tty ? "%-10s %8d" : "%s %d", s->alg->name, s->memsize);
+        for (k = 0; k < num_stats; k++) {
+            if (stat_shown(&stats[k], s)) {
+                printf(" %*.*f", tty ? stats[k].width : 0, stats[k].decimals,
+                       stats[k].value(s));
+            }
+        }
+        printf("\n");
+    }
+}
+
+/* Print the faults of every process of every simulation: a table on a
+ * terminal, otherwise lines of "alg memsize process refs faults rate".
+ */
+void print_processes(struct sim *sims, int nsims) {
+    int tty = 0 <= tcgetpgrp(STDOUT_FILENO);
+    int i, k;
+
+    printf("\n");
+    if (tty) {
+        printf("%-10s %8s %8s %16s %12s %10s\n", "Algorithm", "Memsize",
+               "Process", "Refs", "Faults", "Fault rate");
+    }
+    for (i = 0; i < nsims; i++) {
+        struct sim *s = &sims[i];
+        for (k = 0; k < s->params->nprocs; k++) {
+            struct proc_counts *pc = &s->procs[k];
+            printf(tty ? "%-10s %8d %8d %16ld %12ld %10.4f\n"
+                       : "%s %d %d %ld %ld %.4f\n",
+                   s->alg->name, s->memsize, k, pc->refs, pc->misses,
+                   pc->refs > 0 ? (double) pc->misses / pc->refs * 100 : 0);
+        }
+    }
+}
+
+/* Parse a page size such as 4K or 2M. Returns its log2, or -1 if it is
+ * not a power of two of at least 4K (traces in the binary format do not
+ * keep anything finer).
+ */
+int parse_page_size(const char *arg) {
+    char *end;
+    unsigned long size = strtoul(arg, &end, 10);
+    int shift = 0;
+
+    if (*end == 'K' || *end == 'k') {
+        size <<= 10;
+        end++;
+    } else if (*end == 'M' || *end == 'm') {
+        size <<= 20;
+        end++;
+    }
+    if (*end != '\0' || size < 4096 || (size & (size - 1)) != 0) {
+        return -1;
+    }
+    while ((1UL << shift) < size) {
+        shift++;
+    }
+    return shift;
+}
+
+/* Append the comma separated values of a -a or -m option to list.
+ */
+void add_values(char ***list, int *n, char *arg) {
+    char *value;
+
+    for (value = strtok(arg, ","); value != NULL; value = strtok(NULL, ",")) {
+        *list = realloc(*list, (*n + 1) * sizeof(char *));
+        if (*list == NULL) {
+            perror("Malloc failed");
+            exit(1);
+        }
+        (*list)[(*n)++] = value;
+    }
+}
+
+/* Open the n traces in paths and interleave them as processes (see
+ * trace_interleave), with quanta taken from the -q values.
+ */
+struct trace *open_processes(char **paths, int n, char **quanta,
+                             int num_quanta) {
+    struct trace **procs = malloc(n * sizeof(struct trace *));
+    long *lengths = malloc(n * sizeof(long));
+    struct trace *t;
+    int i;
+
+    if (procs == NULL || lengths == NULL) {
+        perror("Malloc failed");
+        exit(1);
+    }
+    if (n > MAX_PROCS) {
+        fprintf(stderr, "Error: at most %d traces\n", MAX_PROCS);
+        exit(1);
+    }
+    if (num_quanta != 0 && num_quanta != 1 && num_quanta != n) {
+        fprintf(stderr, "Error: -q needs one quantum or one per trace\n");
+        exit(1);
+    }
+    for (i = 0; i < n; i++) {
+        lengths[i] = 10000;
+        if (num_quanta > 0) {
+            char *q = quanta[num_quanta == 1 ? 0 : i];
+            if ((lengths[i] = strtol(q, NULL, 10)) <= 0) {
+                fprintf(stderr, "Error: invalid quantum - %s\n", q);
+                exit(1);
+            }
+        }
+        if ((procs[i] = trace_open(paths[i])) == NULL) {
+            perror("Error opening tracefile:");
+            exit(1);
+        }
+    }
+    if ((t = trace_interleave(procs, n, lengths)) == NULL) {
+        perror("Malloc failed");
+        exit(1);
+    }
+    free(procs);
+    free(lengths);
+    return t;
+}
 
 int main(int argc, char *argv[]) {
     int opt;
-    FILE *tfp = stdin;
-    char *replacement_alg = NULL;
-    char *usage = "USAGE: sim -f tracefile -m memorysize -a algorithm\n";
+    struct trace *tfp;
+    char **tracefiles = NULL;
+    int num_tracefiles = 0;
+    char **quanta = NULL;
+    int num_quanta = 0;
+    int local = 0;
+    char **alg_names = NULL;
+    char **memsizes = NULL;
+    int num_alg_names = 0;
+    int num_memsizes = 0;
+    int nthreads = 0;
+    struct sim_params params = {10000, 1.0, 1.0, {0, 0, TLB_LRU, 0}, NULL,
+                                100000, 1, {0, 0, 0, 1, 100}, {0, 0}};
+    char *seriesfile = NULL;
+    char *markerfile = NULL;
+    int only = 0;
+    int collapse = 0;
+    int page_shift = PAGE_SHIFT;
+    int levels = 0;
+    int belady_lo = 0;
+    int belady_hi = 0;
+    struct hugeregion *huge = NULL;
+    int num_huge = 0;
+    char *usage = "USAGE: sim -f tracefile [-f tracefile ... [-q quantum[,...]] [-l]]\n"
+                  "           -m memorysize[,...] -a algorithm[,...] [-t threads]\n"
+                  "           [-r readcost] [-w writecost] [-T window]\n"
+                  "           [-L entries[:ways[:lru|rand]] [-s]] [-p pagesize] [-H start-end]\n"
+                  "           [-o seriesfile [-i interval]] [-k markerfile [-K]] [-c]\n"
+                  "           [-P levels] [-d read:write[:bandwidth[:depth]] [-e reftime]]\n"
+                  "           [-A fixed|adaptive|stride[:pages]] [-B lo-hi]\n"
+                  "  -m and -a may be repeated; every combination is simulated\n"
+                  "  Several -f run as processes, round-robin for -q references each (default\n"
+                  "     10000; a list gives each its own); -l splits memory between them\n"
+                  "     into fixed partitions instead of replacing pages globally\n"
+                  "  -L puts a TLB in front of the page table, -s splits it into I and D\n"
+                  "  -p sets the page size (4K, 16K, 64K, 2M, ...); -H maps the hex address\n"
+                  "     range start-end with 2M huge pages and may be repeated\n"
+                  "  -o writes per-interval CSV rows to file, every -i references (default 100000)\n"
+                  "  -k counts only the references between the markers, after warming up on\n"
+                  "     the ones before; -K simulates only the references between them\n"
+                  "     (text traces only)\n"
+                  "  -c simulates each run of references to one page as a single one\n"
+                  "     (rand, lru, fifo, clock, opt and eclock only; results are exact)\n"
+                  "  -P keeps page tables levels deep (2 to 5) in memory; every TLB miss,\n"
+                  "     or every reference without -L, walks them (not with opt)\n"
+                  "  -d models a swap device with read and write latencies in us, bandwidth\n"
+                  "     in MB/s and queue depth, and reports the time the run takes with a\n"
+                  "     reference taking -e ns (default 100)\n"
+                  "  -A reads pages ahead on faults: the next pages (default 8), a window\n"
+                  "     growing up to pages (default 32) along sequential streams, or pages\n"
+                  "     (default 4) along streams of any stride (not with opt, -c or -B)\n"
+                  "  -B runs every memory size from lo to hi instead of -m, and reports each\n"
+                  "     one where a frame more gives more faults, writing a short trace that\n"
+                  "     shows it to belady-alg-memsize.trace\n";
 
-    while ((opt = getopt(argc, argv, "f:m:a:")) != -1) {
+    while ((opt = getopt(argc, argv, "f:m:a:t:r:w:T:L:sp:H:o:i:k:KcP:q:ld:e:A:B:")) != -1) {
         switch (opt) {
         case 'f':
-            tracefile = optarg;
+            tracefiles = realloc(tracefiles, (num_tracefiles + 1) * sizeof(char *));
+            if (tracefiles == NULL) {
+                perror("Malloc failed");
+                exit(1);
+            }
+            tracefiles[num_tracefiles++] = optarg;
+            break;
+        case 'q':
+            add_values(&quanta, &num_quanta, optarg);
+            break;
+        case 'l':
+            local = 1;
+            break;
+        case 'd':
+            if (!device_parse(&params.device, optarg)) {
+                fprintf(stderr, "Error: invalid device - %s\n", optarg);
+                exit(1);
+            }
+            break;
+        case 'A':
+            if (!readahead_parse(&params.readahead, optarg)) {
+                fprintf(stderr, "Error: invalid read-ahead - %s\n", optarg);
+                exit(1);
+            }
+            break;
+        case 'B':
+            if (sscanf(optarg, "%d-%d", &belady_lo, &belady_hi) != 2 ||
+                belady_lo <= 0 || belady_hi <= belady_lo) {
+                fprintf(stderr, "Error: invalid memory size range - %s\n", optarg);
+                exit(1);
+            }
+            break;
+        case 'e':
+            params.device.ref_ns = strtod(optarg, NULL);
+            if (params.device.ref_ns < 0) {
+                fprintf(stderr, "Error: invalid reference time - %s\n", optarg);
+                exit(1);
+            }
             break;
         case 'm':
-            memsize = (int)strtol(optarg, NULL, 10);
+            add_values(&memsizes, &num_memsizes, optarg);
             break;
         case 'a':
-            replacement_alg = optarg;
+            add_values(&alg_names, &num_alg_names, optarg);
+            break;
+        case 't':
+            nthreads = (int)strtol(optarg, NULL, 10);
+            break;
+        case 'r':
+            params.read_cost = strtod(optarg, NULL);
+            break;
+        case 'w':
+            params.write_cost = strtod(optarg, NULL);
+            break;
+        case 'T':
+            params.window = strtol(optarg, NULL, 10);
+            if (params.window < 1) {
+                fprintf(stderr, "Error: invalid window - %s\n", optarg);
+                exit(1);
+            }
+            break;
+        case 'L':
+            if (!tlb_parse(&params.tlb, optarg)) {
+                fprintf(stderr, "Error: invalid TLB - %s\n", optarg);
+                exit(1);
+            }
+            break;
+        case 's':
+            params.tlb.split = 1;
+            break;
+        case 'p':
+            if ((page_shift = parse_page_size(optarg)) < 0) {
+                fprintf(stderr, "Error: invalid page size - %s\n", optarg);
+                exit(1);
+            }
+            break;
+        case 'o':
+            seriesfile = optarg;
+            break;
+        case 'k':
+            markerfile = optarg;
+            break;
+        case 'K':
+            only = 1;
+            break;
+        case 'c':
+            collapse = 1;
+            break;
+        case 'P':
+            levels = (int)strtol(optarg, NULL, 10);
+            if (levels < 2 || levels > PT_MAX_LEVELS) {
+                fprintf(stderr, "Error: invalid page table depth - %s\n", optarg);
+                exit(1);
+            }
+            break;
+        case 'i':
+            params.interval = strtol(optarg, NULL, 10);
+            if (params.interval <= 0) {
+                fprintf(stderr, "Error: invalid interval - %s\n", optarg);
+                exit(1);
+            }
+            break;
+        case 'H':
+            huge = realloc(huge, (num_huge + 1) * sizeof(struct hugeregion));
+            if (huge == NULL) {
+                perror("Malloc failed");
+                exit(1);
+            }
+            if (sscanf(optarg, "%lx-%lx", &huge[num_huge].start,
+                       &huge[num_huge].end) != 2 ||
+                huge[num_huge].start >= huge[num_huge].end) {
+                fprintf(stderr, "Error: invalid huge page region - %s\n", optarg);
+                exit(1);
+            }
+            num_huge++;
             break;
         default:
             fprintf(stderr, "%s", usage);
             exit(1);
         }
     }
-    if (tracefile != NULL) {
-        if((tfp = fopen(tracefile, "r")) == NULL) {
+    if (num_tracefiles <= 1) {
+        if ((tfp = trace_open(num_tracefiles ? tracefiles[0] : NULL)) == NULL) {
             perror("Error opening tracefile:");
             exit(1);
         }
+    } else {
+        tfp = open_processes(tracefiles, num_tracefiles, quanta, num_quanta);
+        params.nprocs = num_tracefiles;
+    }
+    if (params.nprocs == 1 && (local || num_quanta > 0)) {
+        fprintf(stderr, "Error: -q and -l need several traces\n");
+        exit(1);
+    }
+    if (params.nprocs > 1 && markerfile != NULL) {
+        fprintf(stderr, "Error: -k needs a single trace\n");
+        exit(1);
+    }
+    if (markerfile != NULL && !trace_exact(tfp)) {
+        // The markers are single addresses, finer than a page
+        fprintf(stderr, "Error: -k needs a text trace; binary traces only "
+                        "keep page numbers\n");
+        exit(1);
+    }
+    if (local && seriesfile != NULL) {
+        fprintf(stderr, "Error: -l cannot be combined with -o\n");
+        exit(1);
+    }
+
+    if (belady_lo > 0) {
+        if (num_memsizes > 0 || markerfile != NULL || collapse ||
+            seriesfile != NULL || params.nprocs > 1 ||
+            params.readahead.window > 0) {
+            fprintf(stderr, "Error: -B cannot be combined with -m, -k, -c, -o, "
+                            "-A or several traces\n");
+            exit(1);
+        }
+        // Every size in the range, in order
+        int m;
+        for (m = belady_lo; m <= belady_hi; m++) {
+            char *value = malloc(12);
+            if (value == NULL) {
+                perror("Malloc failed");
+                exit(1);
+            }
+            snprintf(value, 12, "%d", m);
+            add_values(&memsizes, &num_memsizes, value);
+        }
     }
 
-    if (replacement_alg == NULL) {
+    if (num_alg_names == 0 || num_memsizes == 0) {
         fprintf(stderr, "%s", usage);
         exit(1);
-    } else {
-        int i;
+    }
+
+    struct functions **chosen = malloc(num_alg_names * sizeof(struct functions *));
+    if (chosen == NULL) {
+        perror("Malloc failed");
+        exit(1);
+    }
+    int lookahead = 0;
+    int i, j;
+    for (j = 0; j < num_alg_names; j++) {
+        chosen[j] = NULL;
         for (i = 0; i < num_algs; i++) {
-            if (strcmp(algs[i].name, replacement_alg) == 0) {
-                init_fcn = algs[i].init;
-                evict_fcn = algs[i].evict;
-                reference_fcn = algs[i].reference;
+            if (strcmp(algs[i].name, alg_names[j]) == 0) {
+                chosen[j] = &algs[i];
+                lookahead |= algs[i].lookahead;
                 break;
             }
         }
-        if (evict_fcn == NULL) {
+        if (chosen[j] == NULL) {
             fprintf(stderr, "Error: invalid replacement algorithm - %s\n",
-                    replacement_alg);
+                    alg_names[j]);
+            exit(1);
+        }
+        if (belady_lo > 0 && chosen[j]->lookahead) {
+            // Witnesses are replayed without the rest of the trace
+            fprintf(stderr, "Error: %s cannot run with -B\n", alg_names[j]);
+            exit(1);
+        }
+        if (levels > 0 && chosen[j]->lookahead) {
+            // Walks are not in the reference string it looks ahead in
+            fprintf(stderr, "Error: %s cannot run with page tables\n",
+                    alg_names[j]);
+            exit(1);
+        }
+        if (params.readahead.window > 0 && chosen[j]->lookahead) {
+            // Pages read ahead are not in the reference string either
+            fprintf(stderr, "Error: %s cannot run with -A\n", alg_names[j]);
+            exit(1);
+        }
+        if (collapse && !chosen[j]->collapsible) {
+            fprintf(stderr, "Error: %s cannot run on collapsed references\n",
+                    alg_names[j]);
+            exit(1);
+        }
+    }
+    for (i = 0; i < num_memsizes; i++) {
+        if (strtol(memsizes[i], NULL, 10) <= 0 ||
+            (local && strtol(memsizes[i], NULL, 10) < params.nprocs)) {
+            fprintf(stderr, "Error: invalid memory size - %s\n", memsizes[i]);
             exit(1);
         }
     }
 
+    // With local partitions, every process gets a simulation of its own
+    int nparts = local ? params.nprocs : 1;
+    int nconfigs = num_alg_names * num_memsizes;
+    int nsims = nconfigs * nparts;
 
-    init_pagetable();
-    coremap = calloc((size_t) memsize, sizeof(struct frame));
-    if (coremap == NULL) {
-        perror("Malloc failed");
+    // Use every core unless told otherwise, but no more threads than runs
+    if (nthreads <= 0) {
+        nthreads = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    }
+    if (nthreads > nsims) {
+        nthreads = nsims;
+    }
+    // Reading ahead adds pages to the shared index as the runs go
+    if (nthreads < 1 || params.readahead.window > 0) {
+        nthreads = 1;
+    }
+
+    struct region region;
+    if (markerfile != NULL && !region_read(&region, markerfile)) {
+        perror("Error reading marker file:");
+        exit(1);
+    }
+
+    if (collapse && params.readahead.window > 0) {
+        // The page of a run is no longer the last one the algorithm saw
+        fprintf(stderr, "Error: -c cannot be combined with -A\n");
+        exit(1);
+    }
+    if (collapse && levels > 0 && params.tlb.entries == 0) {
+        // Without a TLB, the repeats would walk the page tables too
+        fprintf(stderr, "Error: -c with -P needs a TLB\n");
         exit(1);
     }
 
-    init_fcn();
-    replay_trace(tfp);
-    //print_pagetable();
+    if (seriesfile != NULL) {
+        if (collapse) {
+            // Intervals would not end on a collapsed reference
+            fprintf(stderr, "Error: -c cannot be combined with -o\n");
+            exit(1);
+        }
+        if ((params.series = fopen(seriesfile, "w")) == NULL) {
+            perror("Error opening series file:");
+            exit(1);
+        }
+        // Fully buffered, since a row is written every interval
+        setvbuf(params.series, NULL, _IOFBF, 1 << 20);
+        fprintf(params.series, "algorithm,memsize,refs,hits,misses,evictions,"
+                               "distinct_pages,resident\n");
+    }
 
+    struct pageindex *index = pageindex_create((unsigned int) page_shift);
+    for (i = 0; i < num_huge; i++) {
+        pageindex_add_huge(index, huge[i].start, huge[i].end);
+    }
+    if (levels > 0) {
+        pageindex_add_tables(index, (unsigned int) levels);
+    }
 
-    printf("\n");
-    if (0 <= tcgetpgrp(STDOUT_FILENO)) {
-        /*
-         * stdout is the controlling terminal.
-         * Stolen from <http://git.savannah.gnu.org/cgit/coreutils.git/tree/src/ls.c#n1318>
-         */
-        printf("Hit count:         %d\n", hit_count);
-        printf("Miss count:        %d\n", miss_count);
-        printf("Total references:  %d\n", ref_count);
-        printf("Hit rate:          %.4f\n", (double) hit_count / ref_count * 100);
-        printf("Miss rate:         %.4f\n", (double) miss_count / ref_count * 100);
+    /* Algorithms that look ahead need the whole trace before they start,
+     * and threads need it to work on their own simulations. Otherwise
+     * all simulations are fed from a single streaming pass.
+     */
+    int decoded = lookahead || nthreads > 1 || belady_lo > 0;
+    struct refs refs;
+    if (decoded) {
+        refs_load(&refs, tfp, index, markerfile != NULL ? &region : NULL,
+                  only, collapse);
+        if (lookahead) {
+            refs_link(&refs, index->count);
+        }
+    }
+
+    struct sim *sims = malloc(nsims * sizeof(struct sim));
+    if (sims == NULL) {
+        perror("Malloc failed");
+        exit(1);
+    }
+    for (j = 0; j < num_alg_names; j++) {
+        for (i = 0; i < num_memsizes; i++) {
+            int memsize = (int) strtol(memsizes[i], NULL, 10);
+            int k;
+            for (k = 0; k < nparts; k++) {
+                // Equal partitions, the first ones taking the remainder
+                struct sim *s = &sims[(j * num_memsizes + i) * nparts + k];
+                sim_init(s, chosen[j],
+                         memsize / nparts + (k < memsize % nparts),
+                         &params, index, decoded ? &refs : NULL);
+                if (local) {
+                    s->asid = k;
+                }
+            }
+        }
+    }
+
+    if (decoded) {
+        replay_parallel(sims, nsims, &refs, nthreads);
     } else {
-        /*
-         * stdout is a file
-         */
-        printf("%d\n", hit_count);
-        printf("%d\n", miss_count);
-        printf("%d\n", ref_count);
-        printf("%.4f\n", (double) hit_count / ref_count * 100);
-        printf("%.4f\n", (double) miss_count / ref_count * 100);
+        replay_trace(tfp, index, sims, nsims,
+                     markerfile != NULL ? &region : NULL, only, collapse);
+    }
+    if (markerfile != NULL && region.where == REGION_BEFORE) {
+        fprintf(stderr, "Error: start marker not found in trace\n");
+        exit(1);
+    }
+    trace_close(tfp);
+    //print_pagetable(&sims[0]);
+
+    if (params.series != NULL) {
+        // The last interval may be short
+        for (i = 0; i < nsims; i++) {
+            if (sims[i].ref_count % params.interval != 0) {
+                series_row(&sims[i]);
+            }
+        }
+        if (fclose(params.series) != 0) {
+            perror("Error writing series file:");
+            exit(1);
+        }
     }
 
+    for (i = 0; i < nsims; i++) {
+        sim_unmark(&sims[i]);
+    }
+
+    // Gather the partitions of each configuration into its first one
+    if (local) {
+        for (i = 0; i < nconfigs; i++) {
+            for (j = 1; j < nparts; j++) {
+                sim_merge(&sims[i * nparts], &sims[i * nparts + j]);
+            }
+            sims[i] = sims[i * nparts];
+        }
+    }
+
+    if (belady_lo > 0) {
+        belady_report(sims, num_alg_names, num_memsizes, &params, index, &refs,
+                      nthreads);
+        return 0;
+    }
+
+    print_results(sims, nconfigs);
+    if (params.nprocs > 1) {
+        print_processes(sims, nconfigs);
+    }
 
     return(0);
 }
@@ -0,0 +1,206 @@
+#ifndef SIM_H
+#define SIM_H
+
+#include "pagetable.h"
+#include "tlb.h"
+#include "device.h"
+#include "readahead.h"
+
+struct sim;
+
+/* Settings from the command line shared by all simulations.
+ */
+struct sim_params {
+    long window;             // Working-set window in references (wsclock,
+                             // ws), fault interval threshold (pff), or
+                             // span of the history (aging)
+    double read_cost;        // Cost of reading a page in on a miss
+    double write_cost;       // Cost of writing a dirty victim back
+    struct tlb_config tlb;
+    FILE *series;            // Per-interval statistics go here, if not NULL
+    long interval;           // Length of an interval in references
+    int nprocs;              // Processes whose traces are interleaved
+    struct device_config device;
+    struct readahead_config readahead;
+};
+
+/* Statistics of one simulation for the current interval, written out as
+ * a CSV row at its end.
+ */
+struct series {
+    long hits;               // Counts at the start of the interval
+    long misses;
+    long evictions;
+    unsigned int *seen;      // Interval number + 1 in which each page was
+    unsigned int nseen;      // last touched
+    long distinct;           // Pages touched in the interval
+};
+
+/* The algs array gives us a mapping between the name of an eviction
+ * algorithm as given in a command line argument, and the functions to
+ * call to set it up, to select the victim page and on every reference.
+ */
+struct functions {
+    char *name;
+    void (*init)(struct sim *s);
+    int (*evict)(struct sim *s);
+    void (*reference)(struct sim *s, int frame);
+    int lookahead;   // Needs the whole reference string before it starts
+    int collapsible; // A repeated reference to the page just referenced
+                     // cannot change its state, see access_repeat
+};
+
+/* Counts of one process, when several share memory.
+ */
+struct proc_counts {
+    long refs;
+    long misses;
+};
+
+/* Counters of a simulation that a marker region restricts, see
+ * sim_mark.
+ */
+struct sim_counts {
+    long hits;
+    long misses;
+    long refs;
+    long writebacks;
+    long evictions;
+    long space_time;
+    long walks;
+    long pt_misses;
+    long pt_space_time;
+    long prefetches;
+    long useful;
+    long wasted;
+    long tlb_hits[2];        // Data and instruction TLB
+    long tlb_misses[2];
+};
+
+/* All of the state of one simulation: a replacement algorithm running
+ * with a fixed number of page frames. Several simulations can be fed
+ * the same trace side by side.
+ */
+struct sim {
+    struct functions *alg;
+    int memsize;
+    const struct sim_params *params;
+
+    /* The coremap holds information about physical memory.
+     * The index into coremap is the physical page number stored
+     * as pframe in the page table entry (struct page).
+     */
+    struct coremap coremap;
+    int frames_used;         // Frames [0, frames_used) have been used
+    int *free_frames;        // Stack of released frames below frames_used
+    int num_free;
+
+    // Page table, indexed by page number from the shared page index
+    struct page *pages;
+    unsigned int npages;
+
+    struct pageindex *index;
+    const struct refs *refs; // Decoded trace, if it was loaded up front
+
+    unsigned int page;       // Page number of the current reference
+    long position;           // Index of the current reference in refs
+
+    long hit_count;
+    long miss_count;
+    long ref_count;
+    long writeback_count;    // Dirty pages written back on eviction
+    long evict_count;        // Pages taken out of memory
+    long space_time;         // Sum of the frames held at every reference
+    addr_t resident_bytes;   // Memory held by resident pages
+    addr_t peak_resident_bytes;
+
+    // Page tables in memory, see pageindex_add_tables
+    long walk_count;         // Page table references made by walks
+    long pt_miss_count;      // Faults on page table pages
+    int pt_frames;           // Frames held by page table pages
+    int peak_pt_frames;
+    long pt_space_time;      // Sum of pt_frames at every reference
+
+    struct tlb *itlb;        // TLBs for instructions and data; the same
+    struct tlb *dtlb;        // one unless split, NULL if there is none
+    struct device *dev;      // Swap device, NULL unless modelled
+
+    struct readahead *ra;    // NULL unless pages are read ahead
+    long prefetch_count;     // Pages read ahead
+    long useful_count;       // Of those, used before they were evicted
+    long wasted_count;       // Evicted without being used
+
+    int asid;                // Process whose references this simulation
+                             // takes (a local partition), -1 for all
+    struct proc_counts *procs; // Indexed by process, NULL if there is one
+
+    struct series *series;   // NULL unless per-interval output is on
+    struct sim_counts mark;  // Counters at the start of the marker region
+
+    void *alg_data;          // Private state of the replacement algorithm
+};
+
+void sim_init(struct sim *s, struct functions *alg, int memsize,
+              const struct sim_params *params, struct pageindex *index,
+              const struct refs *refs);
+double io_cost(struct sim *s);
+long tlb_cycles(struct sim *s);
+void access_mem(struct sim *s, unsigned int page, char type);
+void access_repeat(struct sim *s, char type, unsigned int repeat);
+void write_back(struct sim *s, int frame);
+void release_frame(struct sim *s, int frame);
+void series_row(struct sim *s);
+void sim_mark(struct sim *s);
+void sim_unmark(struct sim *s);
+void sim_merge(struct sim *s, const struct sim *part);
+void sim_free(struct sim *s);
+void belady_report(struct sim *sims, int nalgs, int nsizes,
+                   const struct sim_params *params, struct pageindex *index,
+                   const struct refs *refs, int nthreads);
+void pagetable_grow(struct sim *s, unsigned int page);
+void print_pagetable(struct sim *s);
+
+void rand_init(struct sim *s);
+void lru_init(struct sim *s);
+void clock_init(struct sim *s);
+void fifo_init(struct sim *s);
+void opt_init(struct sim *s);
+void arc_init(struct sim *s);
+void car_init(struct sim *s);
+void twoq_init(struct sim *s);
+void lirs_init(struct sim *s);
+void eclock_init(struct sim *s);
+void wsclock_init(struct sim *s);
+void ws_init(struct sim *s);
+void pff_init(struct sim *s);
+void aging_init(struct sim *s);
+
+int rand_evict(struct sim *s);
+int lru_evict(struct sim *s);
+int clock_evict(struct sim *s);
+int fifo_evict(struct sim *s);
+int opt_evict(struct sim *s);
+int arc_evict(struct sim *s);
+int car_evict(struct sim *s);
+int twoq_evict(struct sim *s);
+int lirs_evict(struct sim *s);
+int eclock_evict(struct sim *s);
+int wsclock_evict(struct sim *s);
+int ws_evict(struct sim *s);
+int pff_evict(struct sim *s);
+int aging_evict(struct sim *s);
+
+// Functions called when memory is referenced
+void lru_reference(struct sim *s, int frame);
+void opt_reference(struct sim *s, int frame);
+void arc_reference(struct sim *s, int frame);
+void car_reference(struct sim *s, int frame);
+void twoq_reference(struct sim *s, int frame);
+void lirs_reference(struct sim *s, int frame);
+void clock_reference(struct sim *s, int frame);
+void wsclock_reference(struct sim *s, int frame);
+void ws_reference(struct sim *s, int frame);
+void pff_reference(struct sim *s, int frame);
+void aging_reference(struct sim *s, int frame);
+
+#endif
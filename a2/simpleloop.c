@@ -1,6 +1,7 @@
 #include <stdio.h>
 #include <unistd.h>
 #include <stdlib.h>
+#include "memtrace.h"
 
 #define RECORD_SIZE 128  
 
@@ -12,6 +13,7 @@ void heap_loop(int iters) {
 	int i;
 	struct krec *ptr = malloc(iters * sizeof(struct krec));
 	for(i = 0; i < iters; i++) {
+		MEMTRACE_STORE(&ptr[i].d[0]);
 		ptr[i].d[0] = (double) i;
 	}
 	free(ptr);
@@ -21,6 +23,7 @@ void stack_loop(int iters) {
 	int i;
 	struct krec a[iters];
 	for(i = 0; i < iters; i++) {
+		MEMTRACE_STORE(&a[i].d[0]);
 		a[i].d[0] = (double)i;
 	}
 }
@@ -38,8 +41,11 @@ int main(int argc, char ** argv) {
 	fclose(marker_fp);
 
 	MARKER_START = 33;
+	/* Built with -DMEMTRACE, only the region between the markers is traced */
+	MEMTRACE_START("simpleloop.bin");
 	heap_loop(10000);
 	//stack_loop(100);
+	MEMTRACE_STOP();
 	MARKER_END = 34;
 
 	return 0;
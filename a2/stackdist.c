@@ -0,0 +1,160 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "stackdist.h"
+
+static void *xrealloc(void *p, size_t size) {
+    if ((p = realloc(p, size)) == NULL) {
+        perror("Malloc failed");
+        exit(1);
+    }
+    return p;
+}
+
+/* Add delta at time i of the Fenwick tree.
+ */
+static void tree_add(struct stackdist *sd, long i, int delta) {
+    for (i++; i <= sd->capacity; i += i & -i) {
+        sd->tree[i] += delta;
+    }
+}
+
+/* Number of marked times in [0, i].
+ */
+static unsigned long tree_sum(struct stackdist *sd, long i) {
+    unsigned long sum = 0;
+    for (i++; i > 0; i -= i & -i) {
+        sum += sd->tree[i];
+    }
+    return sum;
+}
+
+/* Renumber the marked times 0 .. live-1, keeping their order, so the tree
+ * only ever needs room for a small multiple of the number of pages.
+ */
+static void compact(struct stackdist *sd) {
+    long capacity = sd->capacity;
+    long i, k = 0;
+
+    while (capacity < sd->live * 4) {
+        capacity *= 2;
+    }
+    unsigned int *owner = calloc((size_t) capacity, sizeof(unsigned int));
+    if (owner == NULL) {
+        perror("Malloc failed");
+        exit(1);
+    }
+    for (i = 0; i < sd->now; i++) {
+        if (sd->owner[i] != 0) {
+            owner[k] = sd->owner[i];
+            sd->last[sd->owner[i] - 1] = k;
+            k++;
+        }
+    }
+    free(sd->owner);
+    sd->owner = owner;
+    sd->now = k;
+    sd->capacity = capacity;
+
+    // Build the tree over [0, k) all set, in linear time
+    sd->tree = xrealloc(sd->tree, (size_t) (capacity + 1) * sizeof(unsigned int));
+    memset(sd->tree, 0, (size_t) (capacity + 1) * sizeof(unsigned int));
+    for (i = 1; i <= capacity; i++) {
+        sd->tree[i] += i <= k;
+        long parent = i + (i & -i);
+        if (parent <= capacity) {
+            sd->tree[parent] += sd->tree[i];
+        }
+    }
+}
+
+struct stackdist *stackdist_create(void) {
+    struct stackdist *sd = calloc(1, sizeof(struct stackdist));
+    if (sd == NULL) {
+        perror("Malloc failed");
+        exit(1);
+    }
+    sd->capacity = 1 << 16;
+    sd->tree = calloc((size_t) sd->capacity + 1, sizeof(unsigned int));
+    sd->owner = calloc((size_t) sd->capacity, sizeof(unsigned int));
+    if (sd->tree == NULL || sd->owner == NULL) {
+        perror("Malloc failed");
+        exit(1);
+    }
+    return sd;
+}
+
+/* Record a reference to page (a page number from the page index).
+ * Returns its stack distance, or 0 if the page was never seen before.
+ */
+unsigned int stackdist_access(struct stackdist *sd, unsigned int page) {
+    unsigned int dist = 0;
+
+    if (page >= sd->npages) {
+        unsigned int n = sd->npages ? sd->npages : 1 << 10;
+        while (n <= page) {
+            n *= 2;
+        }
+        sd->last = xrealloc(sd->last, n * sizeof(long));
+        memset(sd->last + sd->npages, 0xff, (n - sd->npages) * sizeof(long));
+        sd->npages = n;
+    }
+    if (sd->now == sd->capacity) {
+        compact(sd);
+    }
+
+    sd->refs++;
+    long last = sd->last[page];
+    if (last < 0) {
+        sd->cold++;
+        sd->live++;
+    } else {
+        dist = (unsigned int)
+            (tree_sum(sd, sd->now - 1) - tree_sum(sd, last) + 1);
+        if (dist >= sd->histsize) {
+            unsigned int n = sd->histsize ? sd->histsize : 1 << 10;
+            while (n <= dist) {
+                n *= 2;
+            }
+            sd->hist = xrealloc(sd->hist, n * sizeof(unsigned long));
+            memset(sd->hist + sd->histsize, 0,
+                   (n - sd->histsize) * sizeof(unsigned long));
+            sd->histsize = n;
+        }
+        sd->hist[dist]++;
+        if (dist > sd->maxdist) {
+            sd->maxdist = dist;
+        }
+        tree_add(sd, last, -1);
+        sd->owner[last] = 0;
+    }
+
+    tree_add(sd, sd->now, 1);
+    sd->owner[sd->now] = page + 1;
+    sd->last[page] = sd->now++;
+    return dist;
+}
+
+/* Take page off the stack, as if it had never been referenced, so that
+ * it no longer counts towards the distances of the others.
+ */
+void stackdist_forget(struct stackdist *sd, unsigned int page) {
+    if (page < sd->npages && sd->last[page] >= 0) {
+        tree_add(sd, sd->last[page], -1);
+        sd->owner[sd->last[page]] = 0;
+        sd->last[page] = -1;
+        sd->live--;
+    }
+}
+
+/* Number of hits LRU gets with memsize frames.
+ */
+unsigned long stackdist_hits(struct stackdist *sd, unsigned int memsize) {
+    unsigned long hits = 0;
+    unsigned int d;
+
+    for (d = 1; d <= memsize && d <= sd->maxdist; d++) {
+        hits += sd->hist[d];
+    }
+    return hits;
+}
@@ -0,0 +1,37 @@
+#ifndef STACKDIST_H
+#define STACKDIST_H
+
+/* Mattson stack-distance analysis for LRU.
+ *
+ * The stack distance of a reference is the number of distinct pages
+ * referenced since the previous reference to the same page, that page
+ * included. Under LRU with m frames a reference hits exactly when its
+ * stack distance is at most m, so one pass that builds a histogram of
+ * distances gives the miss count for every memory size at once.
+ *
+ * Each page's last access time is marked in a Fenwick tree, so the
+ * number of distinct pages since then is a prefix-sum difference, and
+ * every reference costs O(log n).
+ */
+struct stackdist {
+    unsigned int *tree;     // Fenwick tree over access times
+    unsigned int *owner;    // Page number + 1 whose last access is at a time
+    long *last;             // Last access time of each page, -1 if none
+    unsigned int npages;    // Allocated length of last
+    long now;               // Next access time
+    long capacity;          // Number of access times the tree can hold
+    long live;              // Number of marked times (distinct pages)
+
+    unsigned long *hist;    // hist[d]: references at stack distance d
+    unsigned int maxdist;   // Largest stack distance seen
+    unsigned int histsize;  // Allocated length of hist
+    unsigned long cold;     // References to pages never seen before
+    unsigned long refs;
+};
+
+struct stackdist *stackdist_create(void);
+unsigned int stackdist_access(struct stackdist *sd, unsigned int page);
+void stackdist_forget(struct stackdist *sd, unsigned int page);
+unsigned long stackdist_hits(struct stackdist *sd, unsigned int memsize);
+
+#endif
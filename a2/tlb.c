@@ -0,0 +1,110 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "tlb.h"
+
+/* Parse a -L argument of the form entries[:ways[:lru|rand]] into c.
+ * Returns 0 if it is not valid.
+ */
+int tlb_parse(struct tlb_config *c, char *arg) {
+    char *end;
+
+    c->entries = (int) strtol(arg, &end, 10);
+    c->ways = 0;
+    c->policy = TLB_LRU;
+    if (*end == ':') {
+        c->ways = (int) strtol(end + 1, &end, 10);
+        if (*end == ':') {
+            if (strcmp(end + 1, "lru") == 0) {
+                c->policy = TLB_LRU;
+            } else if (strcmp(end + 1, "rand") == 0) {
+                c->policy = TLB_RAND;
+            } else {
+                return 0;
+            }
+            end += strlen(end);
+        }
+    }
+    if (*end != '\0' || c->entries <= 0 || c->ways < 0) {
+        return 0;
+    }
+    if (c->ways == 0) {
+        c->ways = c->entries;
+    }
+    return c->ways <= c->entries && c->entries % c->ways == 0;
+}
+
+struct tlb *tlb_create(const struct tlb_config *c) {
+    struct tlb *t = malloc(sizeof(struct tlb));
+    if (t == NULL) {
+        perror("Malloc failed");
+        exit(1);
+    }
+    t->sets = c->entries / c->ways;
+    t->ways = c->ways;
+    t->policy = c->policy;
+    t->tags = calloc(c->entries, sizeof(addr_t));
+    t->stamp = calloc(c->entries, sizeof(unsigned long));
+    if (t->tags == NULL || t->stamp == NULL) {
+        perror("Malloc failed");
+        exit(1);
+    }
+    t->clock = 0;
+    t->xsubi[0] = 0x330e;
+    t->xsubi[1] = 1;
+    t->xsubi[2] = 0;
+    t->hits = 0;
+    t->misses = 0;
+    return t;
+}
+
+/* Look up vpn, loading it into the TLB on a miss. Returns 1 on a hit.
+ */
+int tlb_lookup(struct tlb *t, addr_t vpn) {
+    addr_t *tags = &t->tags[(vpn % t->sets) * t->ways];
+    unsigned long *stamp = &t->stamp[(vpn % t->sets) * t->ways];
+    int victim = 0;
+    int i;
+
+    t->clock++;
+    for (i = 0; i < t->ways; i++) {
+        if (tags[i] == vpn + 1) {
+            stamp[i] = t->clock;
+            t->hits++;
+            return 1;
+        }
+        // empty entries have stamp 0, so they are used first
+        if (stamp[i] < stamp[victim]) {
+            victim = i;
+        }
+    }
+    t->misses++;
+
+    if (t->policy == TLB_RAND && stamp[victim] != 0) {
+        victim = (int)(nrand48(t->xsubi) % t->ways);
+    }
+    tags[victim] = vpn + 1;
+    stamp[victim] = t->clock;
+    return 0;
+}
+
+/* Drop the entry for vpn, if there is one, when its page is evicted.
+ */
+void tlb_invalidate(struct tlb *t, addr_t vpn) {
+    addr_t *tags = &t->tags[(vpn % t->sets) * t->ways];
+    int i;
+
+    for (i = 0; i < t->ways; i++) {
+        if (tags[i] == vpn + 1) {
+            tags[i] = 0;
+            t->stamp[(vpn % t->sets) * t->ways + i] = 0;
+            return;
+        }
+    }
+}
+
+void tlb_free(struct tlb *t) {
+    free(t->tags);
+    free(t->stamp);
+    free(t);
+}
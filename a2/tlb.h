@@ -0,0 +1,47 @@
+#ifndef TLB_H
+#define TLB_H
+
+#include "pagetable.h"
+
+/* A set-associative translation lookaside buffer in front of the page
+ * table. Entries are tagged with the virtual page number and the page
+ * size, and the set is picked by the low bits of the page number as in
+ * hardware. A hit costs TLB_HIT_CYCLES, a miss a page walk of
+ * TLB_WALK_CYCLES on top of that.
+ */
+
+#define TLB_HIT_CYCLES 1
+#define TLB_WALK_CYCLES 30
+
+// Tags carry the page shift from this bit up, above the address space ID
+#define TLB_SHIFT_BIT 58
+
+enum { TLB_LRU, TLB_RAND };
+
+struct tlb_config {
+    int entries;            // 0 if there is no TLB
+    int ways;               // Entries per set; 0 for fully associative
+    int policy;             // TLB_LRU or TLB_RAND
+    int split;              // Separate TLBs for instructions and data
+};
+
+struct tlb {
+    int sets;
+    int ways;
+    int policy;
+    addr_t *tags;           // Virtual page number + 1 of each entry, 0 if
+                            // invalid; set i is tags[i * ways .. + ways)
+    unsigned long *stamp;   // Last use of each entry, for LRU
+    unsigned long clock;
+    unsigned short xsubi[3];
+    long hits;
+    long misses;
+};
+
+int tlb_parse(struct tlb_config *c, char *arg);
+struct tlb *tlb_create(const struct tlb_config *c);
+int tlb_lookup(struct tlb *t, addr_t vpn);
+void tlb_invalidate(struct tlb *t, addr_t vpn);
+void tlb_free(struct tlb *t);
+
+#endif
@@ -0,0 +1,490 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "trace.h"
+#include "bintrace.h"
+#include "zstream.h"
+
+#define MAXLINE 256
+
+// Size of the read buffer used when the trace is not a regular file
+#define TRACE_BUFSIZE (4 << 20)
+
+struct trace {
+    int fd;
+    int mapped;         // 1 if base is an mmap of the whole file
+    int eof;            // 1 once there is nothing left to read into base
+    int binary;         // 1 for the compact format described in bintrace.h
+    char *base;         // File mapping or read buffer
+    size_t size;        // Length of the mapping or capacity of the buffer
+    const char *pos;    // Next unparsed byte
+    const char *end;    // One past the last complete line available
+    const char *limit;  // One past the last byte read into the buffer
+    char tail[MAXLINE + 1];  // Last line of a mapped file with no newline
+    struct zstream *z;  // Decompressor the buffer is filled from, NULL
+                        // unless the file is compressed
+
+    // Binary format decoder state
+    unsigned int page_shift;
+    addr_t prev[2];     // Previous page of the I and data streams
+    long count;         // Reference count from the header, -1 if unknown
+
+    // Interleaving of several traces (trace_interleave), NULL otherwise
+    struct trace **procs;
+    long *quanta;
+    int nprocs;
+    int cur;            // Process now running
+    long left;          // References left in its quantum
+    int live;           // Processes whose trace has not ended
+};
+
+/* Hex digit values plus one, so that 0 marks a non-hex character and
+ * the digit loop needs a single test per character.
+ */
+static const unsigned char hexval[256] = {
+    ['0'] = 1, ['1'] = 2, ['2'] = 3, ['3'] = 4, ['4'] = 5,
+    ['5'] = 6, ['6'] = 7, ['7'] = 8, ['8'] = 9, ['9'] = 10,
+    ['a'] = 11, ['b'] = 12, ['c'] = 13, ['d'] = 14, ['e'] = 15, ['f'] = 16,
+    ['A'] = 11, ['B'] = 12, ['C'] = 13, ['D'] = 14, ['E'] = 15, ['F'] = 16,
+};
+
+/* Parse the line starting at *pp into ref and advance *pp past it.
+ * Every line handed to the parser ends in '\n', so none of the scans
+ * below has to check for the end of the buffer.
+ * Returns 1 if the line held a memory reference, 0 otherwise (valgrind
+ * "==pid==" chatter, blank or malformed lines).
+ */
+static int parse_line(const char **pp, const char *end, struct trace_ref *ref) {
+    const unsigned char *p = (const unsigned char *) *pp;
+    addr_t vaddr = 0;
+    unsigned int length = 0;
+    unsigned int d;
+    int found = 0;
+
+    while (*p == ' ') {
+        p++;
+    }
+    ref->type = (char) *p;
+    if (*p != '=' && *p != '\n') {
+        p++;
+        while (*p == ' ') {
+            p++;
+        }
+        const unsigned char *digits = p;
+        while ((d = hexval[*p]) != 0) {
+            vaddr = (vaddr << 4) | (d - 1);
+            p++;
+        }
+        if (p != digits && *p == ',') {
+            p++;
+            while ((d = (unsigned int) (*p - '0')) < 10) {
+                length = length * 10 + d;
+                p++;
+            }
+            ref->vaddr = vaddr;
+            ref->length = length;
+            found = 1;
+        }
+    }
+
+    // Skip whatever is left of the line
+    if (*p != '\n') {
+        p = memchr(p, '\n', (size_t) (end - (const char *) p));
+    }
+    *pp = (const char *) p + 1;
+    return found;
+}
+
+/* Find the end of the last complete line in [start, stop).
+ */
+static const char *last_line_end(const char *start, const char *stop) {
+    while (stop > start && stop[-1] != '\n') {
+        stop--;
+    }
+    return stop;
+}
+
+/* Move the unconsumed bytes of the read buffer to its start and top it
+ * up from the file.
+ */
+static void fill_buffer(struct trace *t) {
+    size_t keep = (size_t) (t->limit - t->pos);
+    memmove(t->base, t->pos, keep);
+    char *fill = t->base + keep;
+    char *stop = t->base + t->size;
+
+    while (fill < stop && !t->eof) {
+        size_t want = (size_t) (stop - fill);
+        ssize_t n = t->z != NULL ? zstream_read(t->z, fill, want)
+                                 : read(t->fd, fill, want);
+        if (n < 0) {
+            perror("Error reading tracefile:");
+            exit(1);
+        }
+        if (n == 0) {
+            t->eof = 1;
+            break;
+        }
+        fill += n;
+    }
+
+    t->pos = t->base;
+    t->end = t->limit = fill;
+}
+
+/* Make more lines available to next_text.
+ * Returns 0 once the whole trace has been consumed.
+ */
+static int refill(struct trace *t) {
+    if (t->mapped) {
+        // The only thing left after the mapping is an unterminated last line
+        if (t->eof || t->limit == t->end) {
+            return 0;
+        }
+        size_t len = (size_t) (t->limit - t->end);
+        if (len > MAXLINE) {
+            len = MAXLINE;
+        }
+        memcpy(t->tail, t->end, len);
+        t->tail[len] = '\n';
+        t->pos = t->tail;
+        t->end = t->tail + len + 1;
+        t->eof = 1;
+        return 1;
+    }
+
+    if (t->eof && t->pos == t->limit) {
+        return 0;
+    }
+
+    fill_buffer(t);
+    char *fill = (char *) t->limit;
+    t->end = last_line_end(t->base, fill);
+    if (t->end == t->base && fill == t->base + t->size) {
+        // A single line longer than the whole buffer; drop it
+        t->limit = t->end = t->base;
+        return 1;
+    }
+    if (t->eof && t->end != fill) {
+        // Terminate the final line (the buffer has a spare byte for this)
+        *fill++ = '\n';
+        t->limit = t->end = fill;
+    }
+    return 1;
+}
+
+static int next_text(struct trace *t, struct trace_ref *ref) {
+    while (1) {
+        while (t->pos < t->end) {
+            if (parse_line(&t->pos, t->end, ref)) {
+                return 1;
+            }
+        }
+        if (!refill(t)) {
+            return 0;
+        }
+    }
+}
+
+static int next_binary(struct trace *t, struct trace_ref *ref) {
+    if (t->limit - t->pos < BINTRACE_VARINT_MAX && !t->eof && !t->mapped) {
+        fill_buffer(t);
+    }
+
+    const unsigned char *p = (const unsigned char *) t->pos;
+    const unsigned char *limit = (const unsigned char *) t->limit;
+    unsigned long tag = 0;
+    unsigned int shift = 0;
+    unsigned char c;
+    do {
+        if (p == limit) {
+            // End of the trace (a truncated last record is ignored)
+            return 0;
+        }
+        c = *p++;
+        tag |= (unsigned long) (c & 0x7f) << shift;
+        shift += 7;
+    } while (c & 0x80);
+    t->pos = (const char *) p;
+
+    unsigned int code = tag & 3;
+    int stream = code != 0;
+    unsigned long zz = tag >> 2;
+    t->prev[stream] += (addr_t) ((zz >> 1) ^ -(zz & 1));
+
+    ref->type = bintrace_types[code];
+    ref->vaddr = t->prev[stream] << t->page_shift;
+    ref->length = 0;
+    return 1;
+}
+
+/* Check for a binary trace header at t->pos and, if there is one, switch
+ * the reader to the binary decoder.
+ * Returns -1 if the header is from an unsupported version or has flags
+ * this reader does not know.
+ */
+static int detect_binary(struct trace *t) {
+    struct bintrace_header h;
+
+    t->count = -1;
+    if (t->limit - t->pos < (long) sizeof(h) ||
+        memcmp(t->pos, BINTRACE_MAGIC, sizeof(h.magic)) != 0) {
+        return 0;
+    }
+    memcpy(&h, t->pos, sizeof(h));
+    if (h.version != BINTRACE_VERSION || (h.flags & ~BINTRACE_PAGES) != 0) {
+        return -1;
+    }
+    t->binary = 1;
+    t->page_shift = h.page_shift;
+    t->count = h.count > 0 ? (long) h.count : -1;
+    t->pos += sizeof(h);
+    t->end = t->limit;
+    return 1;
+}
+
+/* Restart the read buffer of t, which holds the start of a compressed
+ * file, on the output of a decompressor of format fed with it and the
+ * rest of the file.
+ * Returns 0 and sets errno on failure.
+ */
+static int start_decompressor(struct trace *t, int format) {
+    t->z = zstream_open(format, t->base, (size_t) (t->limit - t->base),
+                        t->eof ? -1 : t->fd);
+    if (t->z == NULL) {
+        return 0;
+    }
+    t->eof = 0;
+    t->pos = t->end = t->limit = t->base;
+    fill_buffer(t);
+    t->end = t->base;
+    return 1;
+}
+
+/* Open the trace at path, or stdin if path is NULL. Text (lackey) and
+ * binary (trace2bin) traces are told apart by the binary header, and
+ * either may be compressed with gzip or zstd (see zstream.h).
+ * Returns NULL and sets errno on failure.
+ */
+struct trace *trace_open(const char *path) {
+    struct trace *t = calloc(1, sizeof(struct trace));
+    if (t == NULL) {
+        return NULL;
+    }
+
+    if (path == NULL) {
+        t->fd = STDIN_FILENO;
+    } else if ((t->fd = open(path, O_RDONLY)) < 0) {
+        free(t);
+        return NULL;
+    }
+
+    struct stat st;
+    if (fstat(t->fd, &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0) {
+        void *map = mmap(NULL, (size_t) st.st_size, PROT_READ, MAP_PRIVATE,
+                         t->fd, 0);
+        if (map != MAP_FAILED &&
+            zstream_format(map, (size_t) st.st_size) != ZSTREAM_NONE) {
+            // Compressed: streamed through the decompressor instead
+            munmap(map, (size_t) st.st_size);
+        } else if (map != MAP_FAILED) {
+            madvise(map, (size_t) st.st_size, MADV_SEQUENTIAL);
+            t->mapped = 1;
+            t->base = map;
+            t->size = (size_t) st.st_size;
+            t->pos = t->base;
+            t->limit = t->base + t->size;
+            t->end = last_line_end(t->base, t->limit);
+        }
+    }
+
+    if (!t->mapped) {
+        // Not mappable (pipe, terminal, empty file): stream it instead
+        t->size = TRACE_BUFSIZE;
+        if ((t->base = malloc(t->size + 1)) == NULL) {
+            trace_close(t);
+            return NULL;
+        }
+        t->pos = t->end = t->limit = t->base;
+        fill_buffer(t);
+        // Lines are framed by the first refill; binary needs no framing
+        t->end = t->base;
+
+        int format = zstream_format(t->base, (size_t) (t->limit - t->base));
+        if (format != ZSTREAM_NONE && !start_decompressor(t, format)) {
+            int err = errno;
+            trace_close(t);
+            errno = err;
+            return NULL;
+        }
+    }
+
+    if (detect_binary(t) < 0) {
+        trace_close(t);
+        errno = EINVAL;
+        return NULL;
+    }
+    return t;
+}
+
+/* Interleave the n traces in procs as processes scheduled round-robin,
+ * process i running for quanta[i] references at a time. The address of
+ * each reference is tagged with the process number (see ASID_SHIFT). A
+ * process leaves the schedule when its trace ends.
+ */
+struct trace *trace_interleave(struct trace **procs, int n,
+                               const long *quanta) {
+    struct trace *t = calloc(1, sizeof(struct trace));
+    if (t == NULL) {
+        return NULL;
+    }
+    t->procs = malloc(n * sizeof(struct trace *));
+    t->quanta = malloc(n * sizeof(long));
+    if (t->procs == NULL || t->quanta == NULL) {
+        free(t->procs);
+        free(t->quanta);
+        free(t);
+        return NULL;
+    }
+    memcpy(t->procs, procs, n * sizeof(struct trace *));
+    memcpy(t->quanta, quanta, n * sizeof(long));
+    t->nprocs = t->live = n;
+    t->cur = 0;
+    t->left = quanta[0];
+
+    // The total is known only if every trace knows its own
+    t->count = 0;
+    int i;
+    for (i = 0; i < n; i++) {
+        if (trace_count(procs[i]) < 0) {
+            t->count = -1;
+            break;
+        }
+        t->count += trace_count(procs[i]);
+    }
+    return t;
+}
+
+static int next_interleaved(struct trace *t, struct trace_ref *ref) {
+    while (t->live > 0) {
+        if (t->procs[t->cur] != NULL && t->left > 0) {
+            if (trace_next(t->procs[t->cur], ref)) {
+                t->left--;
+                ref->vaddr = (ref->vaddr & ASID_ADDR_MASK) |
+                             (addr_t) t->cur << ASID_SHIFT;
+                return 1;
+            }
+            trace_close(t->procs[t->cur]);
+            t->procs[t->cur] = NULL;
+            t->live--;
+        }
+        // Switch to the next process
+        t->cur = (t->cur + 1) % t->nprocs;
+        t->left = t->quanta[t->cur];
+    }
+    return 0;
+}
+
+/* Read the next memory reference from the trace into ref.
+ * Returns 1 on success and 0 at the end of the trace.
+ */
+int trace_next(struct trace *t, struct trace_ref *ref) {
+    if (t->procs != NULL) {
+        return next_interleaved(t, ref);
+    }
+    if (t->binary) {
+        return next_binary(t, ref);
+    }
+    return next_text(t, ref);
+}
+
+/* Number of references in the trace if the file says so, otherwise -1.
+ */
+long trace_count(struct trace *t) {
+    return t->count;
+}
+
+/* Whether the trace has the exact address and length of every access.
+ * Binary traces only have page numbers (BINTRACE_PAGES), so an address
+ * read from one is the start of its page and its length is 0.
+ */
+int trace_exact(struct trace *t) {
+    if (t->procs != NULL) {
+        int i;
+        for (i = 0; i < t->nprocs; i++) {
+            if (t->procs[i] != NULL && !trace_exact(t->procs[i])) {
+                return 0;
+            }
+        }
+        return 1;
+    }
+    return !t->binary;
+}
+
+void trace_close(struct trace *t) {
+    if (t->procs != NULL) {
+        int i;
+        for (i = 0; i < t->nprocs; i++) {
+            if (t->procs[i] != NULL) {
+                trace_close(t->procs[i]);
+            }
+        }
+        free(t->procs);
+        free(t->quanta);
+        free(t);
+        return;
+    }
+    if (t->z != NULL) {
+        zstream_close(t->z);
+    }
+    if (t->mapped) {
+        munmap(t->base, t->size);
+    } else {
+        free(t->base);
+    }
+    if (t->fd != STDIN_FILENO) {
+        close(t->fd);
+    }
+    free(t);
+}
+
+/* Read the marker addresses from the marker file at path into r.
+ * Returns 0 if the file cannot be read.
+ */
+int region_read(struct region *r, const char *path) {
+    FILE *fp = fopen(path, "r");
+    int n;
+
+    if (fp == NULL) {
+        return 0;
+    }
+    n = fscanf(fp, "%lx %lx", &r->start, &r->end);
+    fclose(fp);
+    r->where = REGION_BEFORE;
+    return n == 2;
+}
+
+/* Return the region of the next reference, at address vaddr.
+ */
+int region_step(struct region *r, addr_t vaddr) {
+    switch (r->where) {
+    case REGION_BEFORE:
+        if (vaddr == r->start) {
+            r->where = REGION_INSIDE;
+            return REGION_START;
+        }
+        return REGION_BEFORE;
+    case REGION_INSIDE:
+        if (vaddr == r->end) {
+            r->where = REGION_AFTER;
+        }
+        return REGION_INSIDE;
+    default:
+        return REGION_AFTER;
+    }
+}
@@ -0,0 +1,52 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include "pagetable.h"
+
+/* A single memory reference from a valgrind lackey trace, e.g.
+ *
+ *     I  04016a4,3
+ *      S 7ff000398,8
+ */
+struct trace_ref {
+    char type;            // I, S, L or M
+    addr_t vaddr;         // Virtual address of the access
+    unsigned int length;  // Size of the access in bytes
+};
+
+/* An open trace, either a valgrind lackey text trace or the compact
+ * binary format written by trace2bin (see bintrace.h). Regular files are
+ * mapped into memory and parsed in place; pipes and stdin are streamed
+ * through a large read buffer. So are compressed traces, which are
+ * decompressed on a thread of their own as they are read.
+ */
+struct trace;
+
+struct trace *trace_open(const char *path);
+struct trace *trace_interleave(struct trace **procs, int n,
+                               const long *quanta);
+int trace_next(struct trace *t, struct trace_ref *ref);
+long trace_count(struct trace *t);
+int trace_exact(struct trace *t);
+void trace_close(struct trace *t);
+
+/* The region of interest of a trace lies between the accesses to the
+ * MARKER_START and MARKER_END variables of the traced program, whose
+ * addresses it writes to a marker file (.marker) as "start end".
+ *
+ * region_step classifies each reference in turn. The access to the start
+ * marker itself is REGION_START and belongs to no region; the access to
+ * the end marker is the last one inside.
+ */
+enum { REGION_BEFORE, REGION_START, REGION_INSIDE, REGION_AFTER };
+
+struct region {
+    addr_t start;
+    addr_t end;
+    int where;
+};
+
+int region_read(struct region *r, const char *path);
+int region_step(struct region *r, addr_t vaddr);
+
+#endif
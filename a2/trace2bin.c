@@ -0,0 +1,74 @@
+#include <stdio.h>
+#include <unistd.h>
+#include <getopt.h>
+#include <stdlib.h>
+#include "trace.h"
+#include "bintrace.h"
+
+/* Convert a valgrind lackey trace into the compact binary format read by
+ * sim (see bintrace.h), so that it only has to be parsed once no matter
+ * how many simulations are run on it.
+ */
+int main(int argc, char *argv[]) {
+    int opt;
+    char *tracefile = NULL;
+    char *outfile = NULL;
+    char *usage = "USAGE: trace2bin [-f tracefile] -o outfile\n";
+
+    while ((opt = getopt(argc, argv, "f:o:")) != -1) {
+        switch (opt) {
+        case 'f':
+            tracefile = optarg;
+            break;
+        case 'o':
+            outfile = optarg;
+            break;
+        default:
+            fprintf(stderr, "%s", usage);
+            exit(1);
+        }
+    }
+    if (outfile == NULL) {
+        fprintf(stderr, "%s", usage);
+        exit(1);
+    }
+
+    struct trace *tfp;
+    if ((tfp = trace_open(tracefile)) == NULL) {
+        perror("Error opening tracefile:");
+        exit(1);
+    }
+
+    FILE *outfp;
+    if ((outfp = fopen(outfile, "wb")) == NULL) {
+        perror("Error opening output file:");
+        exit(1);
+    }
+
+    struct bintrace_writer *w = malloc(sizeof(struct bintrace_writer));
+    if (w == NULL) {
+        perror("Malloc failed");
+        exit(1);
+    }
+    bintrace_writer_init(w, outfp);
+
+    struct trace_ref ref;
+    while (trace_next(tfp, &ref)) {
+        bintrace_put(w, ref.type, ref.vaddr);
+    }
+    bintrace_finish(w);
+
+    long size = ftell(outfp);
+    printf("%lu references, %ld bytes (%.2f bytes/reference)\n",
+           (unsigned long) w->count, size,
+           w->count ? (double) size / w->count : 0.0);
+
+    if (fclose(outfp) != 0) {
+        perror("Error writing output file:");
+        exit(1);
+    }
+    trace_close(tfp);
+    free(w);
+
+    return 0;
+}
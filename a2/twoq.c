@@ -0,0 +1,123 @@
+#include <stdio.h>
+#include <assert.h>
+#include <unistd.h>
+#include <getopt.h>
+#include <stdlib.h>
+#include "sim.h"
+#include "pagelist.h"
+
+
+extern int debug;
+
+/* Full 2Q (Johnson and Shasha, VLDB '94).
+ *
+ * New pages enter A1in, a FIFO of resident pages. When A1in grows past
+ * Kin, its oldest page is evicted and remembered in A1out, a FIFO of at
+ * most Kout non-resident pages. Only a page that is referenced again
+ * while in A1out is promoted to Am, the LRU list of hot pages, so a scan
+ * passes through A1in without disturbing Am.
+ */
+
+enum { TWOQ_NONE, TWOQ_A1IN, TWOQ_A1OUT, TWOQ_AM, TWOQ_PROMOTE };
+
+struct twoq {
+    struct pagelist list[4];  // Indexed by TWOQ_A1IN .. TWOQ_AM
+    unsigned int *prev;       // List links, indexed by page number
+    unsigned int *next;
+    char *where;              // Which list each page is on
+    unsigned int npages;
+    unsigned int kin;         // Target size of A1in
+    unsigned int kout;        // Maximum size of A1out
+};
+
+static void twoq_grow(struct sim *s, struct twoq *q) {
+    if (q->npages < s->npages) {
+        q->prev = page_array_grow(q->prev, sizeof(unsigned int),
+                                  q->npages, s->npages, 0);
+        q->next = page_array_grow(q->next, sizeof(unsigned int),
+                                  q->npages, s->npages, 0);
+        q->where = page_array_grow(q->where, sizeof(char),
+                                   q->npages, s->npages, TWOQ_NONE);
+        q->npages = s->npages;
+    }
+}
+
+static void twoq_move(struct twoq *q, unsigned int page, int to) {
+    int from = q->where[page];
+    if (from >= TWOQ_A1IN && from <= TWOQ_AM) {
+        pagelist_remove(&q->list[from], q->prev, q->next, page);
+    }
+    if (to >= TWOQ_A1IN && to <= TWOQ_AM) {
+        pagelist_push(&q->list[to], q->prev, q->next, page);
+    }
+    q->where[page] = (char) to;
+}
+
+/* Page to evict is chosen using 2Q: the oldest page of A1in if A1in is
+ * over its target size (or Am is empty), otherwise the LRU page of Am.
+ * Returns the slot in the coremap that held the page that
+ * was evicted.
+ */
+int twoq_evict(struct sim *s) {
+    struct twoq *q = s->alg_data;
+    twoq_grow(s, q);
+
+    // Decide on promotion before A1out can drop the page
+    if (q->where[s->page] == TWOQ_A1OUT) {
+        twoq_move(q, s->page, TWOQ_PROMOTE);
+    }
+
+    unsigned int victim;
+    if (q->list[TWOQ_A1IN].size > q->kin || q->list[TWOQ_AM].size == 0) {
+        victim = q->list[TWOQ_A1IN].head;
+        twoq_move(q, victim, TWOQ_A1OUT);
+        if (q->list[TWOQ_A1OUT].size > q->kout) {
+            twoq_move(q, q->list[TWOQ_A1OUT].head, TWOQ_NONE);
+        }
+    } else {
+        victim = q->list[TWOQ_AM].head;
+        twoq_move(q, victim, TWOQ_NONE);
+    }
+
+    return s->pages[victim].pframe;
+}
+
+void twoq_reference(struct sim *s, int frame) {
+    struct twoq *q = s->alg_data;
+    twoq_grow(s, q);
+
+    unsigned int page = s->page;
+    switch (q->where[page]) {
+    case TWOQ_AM:
+    case TWOQ_A1OUT:
+    case TWOQ_PROMOTE:
+        // Hot page, or seen again while remembered in A1out
+        twoq_move(q, page, TWOQ_AM);
+        break;
+    case TWOQ_NONE:
+        twoq_move(q, page, TWOQ_A1IN);
+        break;
+    default:
+        // Hits in A1in leave it alone
+        break;
+    }
+}
+
+/* Initialize any data structures needed for this replacement
+ * algorithm. Kin and Kout are the 25% and 50% recommended by the paper.
+ */
+void twoq_init(struct sim *s) {
+    struct twoq *q = calloc(1, sizeof(struct twoq));
+    if (q == NULL) {
+        perror("Malloc failed");
+        exit(1);
+    }
+    int i;
+    for (i = 0; i < 4; i++) {
+        pagelist_init(&q->list[i]);
+    }
+    q->kin = s->memsize / 4 > 1 ? s->memsize / 4 : 1;
+    q->kout = s->memsize / 2 > 1 ? s->memsize / 2 : 1;
+    s->alg_data = q;
+    twoq_grow(s, q);
+}
@@ -0,0 +1,82 @@
+#include <stdio.h>
+#include <assert.h>
+#include <unistd.h>
+#include <getopt.h>
+#include <stdlib.h>
+#include "sim.h"
+#include "pagelist.h"
+
+
+extern int debug;
+
+/* Denning's working-set policy. The resident set is exactly the set of
+ * pages referenced in the last window references (-T): a page whose last
+ * use falls out of the window gives its frame back to the free pool, so
+ * the allocation grows and shrinks with the program's locality. memsize
+ * only caps it; if the working set does not fit, the LRU page is evicted.
+ *
+ * Resident pages are kept in LRU order, so the pages leaving the window
+ * are always at the head.
+ */
+
+struct ws {
+    struct pagelist lru;      // Resident pages, least recently used first
+    unsigned int *prev;       // List links, indexed by page number
+    unsigned int *next;
+    char *resident;
+    unsigned int npages;
+};
+
+int ws_evict(struct sim *s) {
+    struct ws *ws = s->alg_data;
+    unsigned int victim = pagelist_pop(&ws->lru, ws->prev, ws->next);
+
+    ws->resident[victim] = 0;
+    return s->pages[victim].pframe;
+}
+
+/* Move the page to the MRU end, then drop every page that is no longer
+ * in the working set.
+ */
+void ws_reference(struct sim *s, int frame) {
+    struct ws *ws = s->alg_data;
+    unsigned int page = s->page;
+
+    if (ws->npages < s->npages) {
+        ws->prev = page_array_grow(ws->prev, sizeof(unsigned int),
+                                   ws->npages, s->npages, 0);
+        ws->next = page_array_grow(ws->next, sizeof(unsigned int),
+                                   ws->npages, s->npages, 0);
+        ws->resident = page_array_grow(ws->resident, sizeof(char),
+                                       ws->npages, s->npages, 0);
+        ws->npages = s->npages;
+    }
+
+    if (ws->resident[page]) {
+        pagelist_remove(&ws->lru, ws->prev, ws->next, page);
+    }
+    pagelist_push(&ws->lru, ws->prev, ws->next, page);
+    ws->resident[page] = 1;
+    s->coremap.stamp[frame] = s->ref_count;
+
+    while (1) {
+        unsigned int oldest = ws->lru.head;
+        int f = s->pages[oldest].pframe;
+        if (s->ref_count - (long) s->coremap.stamp[f] < s->params->window) {
+            break;
+        }
+        pagelist_pop(&ws->lru, ws->prev, ws->next);
+        ws->resident[oldest] = 0;
+        release_frame(s, f);
+    }
+}
+
+void ws_init(struct sim *s) {
+    struct ws *ws = calloc(1, sizeof(struct ws));
+    if (ws == NULL) {
+        perror("Malloc failed");
+        exit(1);
+    }
+    pagelist_init(&ws->lru);
+    s->alg_data = ws;
+}
@@ -0,0 +1,89 @@
+#include <stdio.h>
+#include <assert.h>
+#include <unistd.h>
+#include <getopt.h>
+#include <stdlib.h>
+#include "sim.h"
+
+
+extern int debug;
+
+/* WSClock (Carr and Hennessy, SOSP '81): clock with a working-set window.
+ * The hand skips pages that were referenced since it last passed them
+ * and takes the first clean page that has not been
+ * used for more than window references. A dirty page that is out of the
+ * window is written back (counted as a write-back) and left in place,
+ * so it can be taken clean on a later pass.
+ *
+ * The sweep is bounded at two turns of the clock, which is enough to take
+ * any page cleaned on the first. If every page is still in the window,
+ * the least recently used one is taken.
+ */
+
+struct wsclock {
+    // clock hand
+    int hand;
+};
+
+/* Page to evict is chosen using the WSClock algorithm.
+ * Returns the slot in the coremap that held the page that
+ * was evicted.
+ */
+
+int wsclock_evict(struct sim *s) {
+    struct wsclock *wsclock = s->alg_data;
+    struct coremap *coremap = &s->coremap;
+    unsigned long now = s->ref_count;
+    int hand = wsclock->hand;
+    int oldest = -1;
+    int slot = -1;
+    int i;
+
+    for (i = 0; i < 2 * s->memsize; i++) {
+        if (coremap->ref[hand]) {
+            // used since the last pass: second chance
+            coremap->ref[hand] = 0;
+        } else if (now - coremap->stamp[hand] >
+                   (unsigned long) s->params->window) {
+            if (!coremap->dirty[hand]) {
+                slot = hand;
+                break;
+            }
+            // out of the working set: clean it for a later pass
+            write_back(s, hand);
+            coremap->dirty[hand] = 0;
+        }
+
+        if (oldest == -1 || coremap->stamp[hand] < coremap->stamp[oldest]) {
+            oldest = hand;
+        }
+        hand = (hand == s->memsize - 1 ? 0 : hand + 1);
+    }
+
+    if (slot == -1) {
+        slot = oldest;
+    }
+    wsclock->hand = (slot == s->memsize - 1 ? 0 : slot + 1);
+    return slot;
+}
+
+/* Record the time of every reference along with the reference bit, so
+ * the age of a page is exact rather than sampled by the hand.
+ */
+void wsclock_reference(struct sim *s, int frame) {
+    s->coremap.ref[frame] = 1;
+    s->coremap.stamp[frame] = s->ref_count;
+}
+
+/* Initialize any data structures needed for this replacement
+ * algorithm
+ */
+void wsclock_init(struct sim *s) {
+    struct wsclock *wsclock = malloc(sizeof(struct wsclock));
+    if (wsclock == NULL) {
+        perror("Malloc failed");
+        exit(1);
+    }
+    wsclock->hand = 0;
+    s->alg_data = wsclock;
+}
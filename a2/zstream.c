@@ -0,0 +1,344 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <pthread.h>
+#ifdef HAVE_ZLIB
+#include <zlib.h>
+#endif
+#ifdef HAVE_ZSTD
+#include <zstd.h>
+#endif
+#include "zstream.h"
+
+// Compressed input is read in chunks of this size
+#define ZSTREAM_CHUNK (1 << 20)
+
+struct zstream {
+    int format;
+    int fd;                 // Rest of the input after head, -1 if none
+    unsigned char *head;    // Input read before the format was known
+    size_t head_len;        // Length of head, 0 once it is consumed
+    unsigned char *in;      // Chunk of input read from fd
+
+    unsigned char *ring;    // Decompressed output, ZSTREAM_RING bytes
+    size_t written;         // Bytes put in the ring so far
+    size_t taken;           // Bytes taken out of it so far
+    int done;               // The thread has written all there is
+    int closing;            // Nobody reads any more; the thread stops
+
+    pthread_t thread;
+    pthread_mutex_t lock;
+    pthread_cond_t more;    // Output was put in the ring, or it is done
+    pthread_cond_t room;    // Output was taken, or it is closing
+};
+
+/* Compression format of a file starting with the len bytes at head.
+ */
+int zstream_format(const void *head, size_t len) {
+    const unsigned char *p = head;
+
+    if (len >= 2 && p[0] == 0x1f && p[1] == 0x8b) {
+        return ZSTREAM_GZIP;
+    }
+    if (len >= 4 && p[0] == 0x28 && p[1] == 0xb5 && p[2] == 0x2f &&
+        p[3] == 0xfd) {
+        return ZSTREAM_ZSTD;
+    }
+    return ZSTREAM_NONE;
+}
+
+/* Whether format was built in.
+ */
+int zstream_supported(int format) {
+    switch (format) {
+#ifdef HAVE_ZLIB
+    case ZSTREAM_GZIP:
+        return 1;
+#endif
+#ifdef HAVE_ZSTD
+    case ZSTREAM_ZSTD:
+        return 1;
+#endif
+    default:
+        return 0;
+    }
+}
+
+static void corrupt(void) {
+    fprintf(stderr, "Error: corrupt or truncated compressed trace\n");
+    exit(1);
+}
+
+/* Point *p at the next chunk of compressed input: the head first, then
+ * the rest of the file. Returns its length, 0 at the end of the input.
+ */
+static size_t next_input(struct zstream *z, const unsigned char **p) {
+    ssize_t n;
+
+    if (z->head_len > 0) {
+        n = (ssize_t) z->head_len;
+        z->head_len = 0;
+        *p = z->head;
+        return (size_t) n;
+    }
+    if (z->fd < 0) {
+        return 0;
+    }
+    while ((n = read(z->fd, z->in, ZSTREAM_CHUNK)) < 0 && errno == EINTR) {
+    }
+    if (n < 0) {
+        perror("Error reading tracefile:");
+        exit(1);
+    }
+    *p = z->in;
+    return (size_t) n;
+}
+
+/* Wait for room in the ring and point *out at the free space from its
+ * head on, up to its end. Returns the size of that space, or 0 if the
+ * stream is being closed.
+ */
+static size_t ring_space(struct zstream *z, unsigned char **out) {
+    size_t space = 0;
+
+    pthread_mutex_lock(&z->lock);
+    while (z->written - z->taken == ZSTREAM_RING && !z->closing) {
+        pthread_cond_wait(&z->room, &z->lock);
+    }
+    if (!z->closing) {
+        size_t at = z->written % ZSTREAM_RING;
+        space = ZSTREAM_RING - (z->written - z->taken);
+        if (space > ZSTREAM_RING - at) {
+            space = ZSTREAM_RING - at;
+        }
+        *out = z->ring + at;
+    }
+    pthread_mutex_unlock(&z->lock);
+    return space;
+}
+
+/* Hand the n bytes just decompressed at the head of the ring over to
+ * the reader.
+ */
+static void ring_put(struct zstream *z, size_t n) {
+    pthread_mutex_lock(&z->lock);
+    z->written += n;
+    pthread_cond_signal(&z->more);
+    pthread_mutex_unlock(&z->lock);
+}
+
+#ifdef HAVE_ZLIB
+/* Inflate gzip input, which may be several members one after another
+ * as written by cat a.gz b.gz.
+ */
+static void gzip_run(struct zstream *z) {
+    z_stream zs;
+    int inside = 0;             // In the middle of a member
+    int full = 0;               // The last call filled all the space
+    const unsigned char *in;
+
+    memset(&zs, 0, sizeof(zs));
+    // 32 makes zlib take the gzip header
+    if (inflateInit2(&zs, 15 + 32) != Z_OK) {
+        corrupt();
+    }
+    while (1) {
+        if (zs.avail_in == 0 && !full) {
+            size_t n = next_input(z, &in);
+            if (n == 0) {
+                break;
+            }
+            zs.next_in = (unsigned char *) in;
+            zs.avail_in = (unsigned int) n;
+        }
+        unsigned char *out;
+        size_t space = ring_space(z, &out);
+        if (space == 0) {
+            inflateEnd(&zs);
+            return;
+        }
+        zs.next_out = out;
+        zs.avail_out = (unsigned int) space;
+        int ret = inflate(&zs, Z_NO_FLUSH);
+        if (ret == Z_STREAM_END) {
+            inflateReset(&zs);
+            inside = 0;
+        } else if (ret == Z_OK) {
+            inside = 1;
+        } else if (ret != Z_BUF_ERROR) {
+            corrupt();
+        }
+        full = zs.avail_out == 0;
+        ring_put(z, space - zs.avail_out);
+    }
+    if (inside) {
+        corrupt();
+    }
+    inflateEnd(&zs);
+}
+#endif
+
+#ifdef HAVE_ZSTD
+/* Decompress zstd input, which may be several frames.
+ */
+static void zstd_run(struct zstream *z) {
+    ZSTD_DStream *ds = ZSTD_createDStream();
+    ZSTD_inBuffer zin = {NULL, 0, 0};
+    size_t hint = 0;            // 0 when a frame is complete
+    int full = 0;
+    const unsigned char *in;
+
+    if (ds == NULL) {
+        perror("Malloc failed");
+        exit(1);
+    }
+    ZSTD_initDStream(ds);
+    while (1) {
+        if (zin.pos == zin.size && !full) {
+            size_t n = next_input(z, &in);
+            if (n == 0) {
+                break;
+            }
+            zin.src = in;
+            zin.size = n;
+            zin.pos = 0;
+        }
+        unsigned char *out;
+        size_t space = ring_space(z, &out);
+        if (space == 0) {
+            ZSTD_freeDStream(ds);
+            return;
+        }
+        ZSTD_outBuffer zout = {out, space, 0};
+        size_t before = zin.pos;
+        size_t ret = ZSTD_decompressStream(ds, &zout, &zin);
+        if (ZSTD_isError(ret)) {
+            corrupt();
+        }
+        if (zin.pos != before || zout.pos > 0) {
+            hint = ret;
+        }
+        full = zout.pos == zout.size;
+        ring_put(z, zout.pos);
+    }
+    if (hint != 0) {
+        corrupt();
+    }
+    ZSTD_freeDStream(ds);
+}
+#endif
+
+static void *zstream_thread(void *arg) {
+    struct zstream *z = arg;
+
+    switch (z->format) {
+#ifdef HAVE_ZLIB
+    case ZSTREAM_GZIP:
+        gzip_run(z);
+        break;
+#endif
+#ifdef HAVE_ZSTD
+    case ZSTREAM_ZSTD:
+        zstd_run(z);
+        break;
+#endif
+    }
+    pthread_mutex_lock(&z->lock);
+    z->done = 1;
+    pthread_cond_signal(&z->more);
+    pthread_mutex_unlock(&z->lock);
+    return NULL;
+}
+
+/* Start decompressing input in format, made of the len bytes at head
+ * followed by what is left to read from fd (-1 if nothing is).
+ * Returns NULL and sets errno on failure.
+ */
+struct zstream *zstream_open(int format, const void *head, size_t len,
+                             int fd) {
+    struct zstream *z = calloc(1, sizeof(struct zstream));
+
+    if (z == NULL) {
+        return NULL;
+    }
+    if (!zstream_supported(format)) {
+        free(z);
+        errno = ENOTSUP;
+        return NULL;
+    }
+    z->format = format;
+    z->fd = fd;
+    z->head = malloc(len > 0 ? len : 1);
+    z->in = malloc(ZSTREAM_CHUNK);
+    z->ring = malloc(ZSTREAM_RING);
+    if (z->head == NULL || z->in == NULL || z->ring == NULL) {
+        free(z->head);
+        free(z->in);
+        free(z->ring);
+        free(z);
+        return NULL;
+    }
+    memcpy(z->head, head, len);
+    z->head_len = len;
+    pthread_mutex_init(&z->lock, NULL);
+    pthread_cond_init(&z->more, NULL);
+    pthread_cond_init(&z->room, NULL);
+    if ((errno = pthread_create(&z->thread, NULL, zstream_thread, z)) != 0) {
+        free(z->head);
+        free(z->in);
+        free(z->ring);
+        free(z);
+        return NULL;
+    }
+    return z;
+}
+
+/* Read up to n bytes of decompressed output into buf, waiting for the
+ * thread if it has not caught up. Returns the number of bytes read, 0
+ * at the end.
+ */
+ssize_t zstream_read(struct zstream *z, void *buf, size_t n) {
+    size_t avail;
+
+    pthread_mutex_lock(&z->lock);
+    while (z->written == z->taken && !z->done) {
+        pthread_cond_wait(&z->more, &z->lock);
+    }
+    avail = z->written - z->taken;
+    pthread_mutex_unlock(&z->lock);
+
+    if (n > avail) {
+        n = avail;
+    }
+    // The output may wrap around the end of the ring
+    size_t at = z->taken % ZSTREAM_RING;
+    size_t first = n < ZSTREAM_RING - at ? n : ZSTREAM_RING - at;
+    memcpy(buf, z->ring + at, first);
+    memcpy((char *) buf + first, z->ring, n - first);
+
+    pthread_mutex_lock(&z->lock);
+    z->taken += n;
+    pthread_cond_signal(&z->room);
+    pthread_mutex_unlock(&z->lock);
+    return (ssize_t) n;
+}
+
+/* Stop the thread, even before the end of the input, and free z.
+ */
+void zstream_close(struct zstream *z) {
+    pthread_mutex_lock(&z->lock);
+    z->closing = 1;
+    pthread_cond_signal(&z->room);
+    pthread_mutex_unlock(&z->lock);
+    pthread_join(z->thread, NULL);
+
+    pthread_mutex_destroy(&z->lock);
+    pthread_cond_destroy(&z->more);
+    pthread_cond_destroy(&z->room);
+    free(z->head);
+    free(z->in);
+    free(z->ring);
+    free(z);
+}
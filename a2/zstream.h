@@ -0,0 +1,29 @@
+#ifndef ZSTREAM_H
+#define ZSTREAM_H
+
+#include <stddef.h>
+#include <sys/types.h>
+
+/* Decompression of a compressed trace on a thread of its own, so that
+ * it overlaps with the simulations. The thread inflates the input into
+ * a ring buffer of ZSTREAM_RING bytes, and zstream_read takes the output
+ * from there, waiting for it when the ring runs empty.
+ *
+ * gzip needs zlib (HAVE_ZLIB) and zstd needs libzstd (HAVE_ZSTD); a
+ * format that was not built in cannot be opened.
+ */
+
+#define ZSTREAM_RING (8 << 20)
+
+enum { ZSTREAM_NONE, ZSTREAM_GZIP, ZSTREAM_ZSTD };
+
+struct zstream;
+
+int zstream_format(const void *head, size_t len);
+int zstream_supported(int format);
+struct zstream *zstream_open(int format, const void *head, size_t len,
+                             int fd);
+ssize_t zstream_read(struct zstream *z, void *buf, size_t n);
+void zstream_close(struct zstream *z);
+
+#endif